@@ -0,0 +1,84 @@
+/**
+ * @file alloccount.hpp
+ * @brief Replaces the global allocation functions with ones counting every call, for the benches and tests checking what allocates. Include it from exactly one source file of a program.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace TftpServer::Bench {
+    /// NOTE: every allocation in the process goes through the functions below, so a case's allocations are the count's change across it. Single-threaded users only.
+    inline std::size_t allocation_count = 0;
+
+    [[nodiscard]] inline void* countedAlloc(std::size_t size) {
+        allocation_count++;
+
+        if (auto* block = std::malloc((size != 0UL) ? size : 1UL); block != nullptr) {
+            return block;
+        }
+
+        throw std::bad_alloc {};
+    }
+
+    [[nodiscard]] inline void* countedAlignedAlloc(std::size_t size, std::align_val_t align) {
+        const auto alignment = static_cast<std::size_t>(align);
+        allocation_count++;
+
+        if (auto* block = std::aligned_alloc(alignment, (size + alignment - 1UL) / alignment * alignment); block != nullptr) {
+            return block;
+        }
+
+        throw std::bad_alloc {};
+    }
+}
+
+void* operator new(std::size_t size) {
+    return TftpServer::Bench::countedAlloc(size);
+}
+
+void* operator new[](std::size_t size) {
+    return TftpServer::Bench::countedAlloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    return TftpServer::Bench::countedAlignedAlloc(size, align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return TftpServer::Bench::countedAlignedAlloc(size, align);
+}
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, [[maybe_unused]] std::size_t size) noexcept {
+    std::free(block);
+}
+
+void operator delete[](void* block, [[maybe_unused]] std::size_t size) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, [[maybe_unused]] std::align_val_t align) noexcept {
+    std::free(block);
+}
+
+void operator delete[](void* block, [[maybe_unused]] std::align_val_t align) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, [[maybe_unused]] std::size_t size, [[maybe_unused]] std::align_val_t align) noexcept {
+    std::free(block);
+}
+
+void operator delete[](void* block, [[maybe_unused]] std::size_t size, [[maybe_unused]] std::align_val_t align) noexcept {
+    std::free(block);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+#include <netinet/in.h>
+
+namespace TftpServer::Driver {
+    enum class IoBackend {
+        epoll,  // readiness events with plain reads and sends
+        uring   // window reads and sends batched through an io_uring per worker
+    };
+
+    /// NOTE: a bandwidth cap shared by all read transfers to peers within one IPv4 subnet.
+    struct RateClass {
+        in_addr_t network;  // network order, with the host bits cleared
+        in_addr_t mask;     // network order
+        std::size_t rate_bytes;  // octets per second
+    };
+
+    struct ServerConfig {
+        const char* port_cstr;
+        std::size_t cache_bytes;  // cap of the shared file cache, where 0 disables it
+        std::size_t packet_cache_bytes;  // cap of the shared cache of pre-encoded DATA messages, where 0 disables it
+        const char* prewarm_path;        // manifest of files loaded before serving, or null when off
+        std::size_t prewarm_lock_bytes;  // how much of the prewarmed files gets mlocked
+        std::size_t worker_count;
+        std::optional<std::size_t> first_core;  // pins workers to consecutive cores starting here when set
+        IoBackend io_backend;
+        std::size_t max_sessions;  // per worker
+        std::size_t pool_bytes;    // per worker cap of pooled packet buffers
+        bool huge_pages;
+        std::size_t write_behind_bytes;  // cap of upload data queued for the writer thread, where 0 makes sessions write inline
+        const char* metrics_path;        // file rewritten with Prometheus metrics every second, or null when off
+        std::size_t rate_bytes;          // cap of DATA octets per second across all workers, where 0 means unlimited
+        std::size_t session_rate_bytes;  // cap of DATA octets per second for each read transfer, where 0 means unlimited
+        std::vector<RateClass> rate_classes;
+        in_addr_t multicast_group;      // network order, first RFC 2090 group handed out, where INADDR_ANY turns multicast off
+        in_port_t multicast_port;       // network order
+        in_addr_t multicast_interface;  // network order, where INADDR_ANY leaves picking the interface to the routing table
+    };
+
+    inline constexpr auto default_cache_mb = 64UL;
+    inline constexpr auto default_max_sessions = 1024UL;
+    inline constexpr auto default_pool_mb = 256UL;
+    inline constexpr auto default_write_behind_mb = 32UL;
+    inline constexpr auto max_worker_count = 256UL;
+    inline constexpr auto max_rate_classes = 64UL;
+    /// NOTE: each worker streams to its own run of consecutive group addresses, one per file being multicast at once.
+    inline constexpr auto multicast_groups_per_worker = 16UL;
+
+    /// NOTE: expects `<port no.> [--flag value]...` and gives nothing on any malformed or unknown argument.
+    [[nodiscard]] std::optional<ServerConfig> parseConfig(int argc, char* argv[]);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <sys/stat.h>
+#include "driver/files.hpp"
+
+namespace TftpServer::Driver {
+    /// NOTE: a cached copy stays valid only while the file keeps its inode, size, and modification time.
+    struct FileIdentity {
+        dev_t device;
+        ino_t inode;
+        off_t size;
+        std::int64_t mtime_secs;
+        std::int64_t mtime_nsecs;
+
+        [[nodiscard]] friend constexpr bool operator==(const FileIdentity& lhs, const FileIdentity& rhs) noexcept = default;
+    };
+
+    [[nodiscard]] FileIdentity makeFileIdentity(const struct stat& status) noexcept;
+
+    struct FileCacheStats {
+        std::uint64_t block_hits;      // blocks copied from chunks already cached
+        std::uint64_t block_misses;    // blocks which needed disk reads
+        std::uint64_t bytes_served;    // DATA payload octets copied out of the cache
+        std::uint64_t bytes_resident;  // octets reserved by cached files
+        std::uint64_t evictions;
+        std::uint64_t files;
+    };
+
+    struct FileCacheCounters {
+        std::atomic<std::uint64_t> block_hits;
+        std::atomic<std::uint64_t> block_misses;
+        std::atomic<std::uint64_t> bytes_served;
+        std::atomic<std::uint64_t> evictions;
+    };
+
+    /**
+     * @brief Read-only copy of one file, filled lazily in chunks by whichever session first needs each chunk. Sessions of any thread can share it.
+     */
+    class CachedFile {
+    private:
+        std::unique_ptr<unsigned char[]> m_data;
+        std::unique_ptr<std::atomic<unsigned char>[]> m_chunk_states;
+        FileCacheCounters& m_counters;
+        FileIdentity m_identity;
+        std::size_t m_chunk_count;
+        bool m_locked;  // pinned in RAM with `mlock`
+
+        [[nodiscard]] bool ensureChunk(std::size_t chunk_index, const FileHandle& source, bool& loaded_now) noexcept;
+
+    public:
+        CachedFile(const FileIdentity& identity, FileCacheCounters& counters);
+        ~CachedFile();
+
+        CachedFile(const CachedFile& other) = delete;
+        CachedFile& operator=(const CachedFile& other) = delete;
+
+        [[nodiscard]] const FileIdentity& getIdentity() const noexcept;
+
+        /// NOTE: same contract as `FileHandle::readAt`. Chunks not cached yet get loaded from `source`, which must be the same file.
+        [[nodiscard]] long readAt(unsigned char* target, std::size_t length, std::uint64_t offset, const FileHandle& source) noexcept;
+
+        /// NOTE: loads every chunk not cached yet, and gives whether all of them are now.
+        [[nodiscard]] bool prefetch(const FileHandle& source) noexcept;
+
+        /// NOTE: keeps the copy in RAM until it gets destroyed, which needs enough `RLIMIT_MEMLOCK` or `CAP_IPC_LOCK`.
+        [[nodiscard]] bool lockResident() noexcept;
+    };
+
+    /**
+     * @brief Shared cache of hot files keyed by request path, bounded by a memory cap with LRU eviction. Evicted entries stay alive for sessions still holding them.
+     */
+    class FileCache {
+    private:
+        using LruList = std::list<std::pair<std::string, std::shared_ptr<CachedFile>>>;
+
+        LruList m_lru;  // most recently used first
+        std::unordered_map<std::string, LruList::iterator> m_index;
+        FileCacheCounters m_counters;
+        mutable std::mutex m_mutex;
+        std::size_t m_capacity;
+        std::size_t m_used;
+
+    public:
+        explicit FileCache(std::size_t capacity);
+
+        FileCache(const FileCache& other) = delete;
+        FileCache& operator=(const FileCache& other) = delete;
+
+        /// NOTE: gives null when caching is disabled or the file alone exceeds the cap.
+        [[nodiscard]] std::shared_ptr<CachedFile> acquire(const std::string& path, const FileHandle& file);
+
+        [[nodiscard]] FileCacheStats getStats() const;
+    };
+}
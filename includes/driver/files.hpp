@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <sys/stat.h>
+
+namespace TftpServer::Driver {
+    enum class FileAccess {
+        read,
+        write  // creates or truncates the file
+    };
+
+    /**
+     * @brief Owns a file descriptor for one transfer. Reads are positional, so a session can fetch any block straight into its packet buffer without seeking.
+     */
+    class FileHandle {
+    private:
+        int m_fd;
+
+    public:
+        FileHandle() noexcept;
+        explicit FileHandle(const std::string& path, FileAccess access = FileAccess::read) noexcept;
+        ~FileHandle();
+
+        FileHandle(const FileHandle& other) = delete;
+        FileHandle& operator=(const FileHandle& other) = delete;
+
+        FileHandle(FileHandle&& other) noexcept;
+        FileHandle& operator=(FileHandle&& other) noexcept;
+
+        [[nodiscard]] bool isOpen() const noexcept;
+        [[nodiscard]] int getFd() const noexcept;
+        [[nodiscard]] std::optional<struct stat> getStatus() const noexcept;
+
+        /// NOTE: gives a second handle on the same open file, e.g. for a background thread which outlives the transfer. It is closed when duplicating failed.
+        [[nodiscard]] FileHandle duplicate() const noexcept;
+
+        /// NOTE: returns the octets read, which only fall short of `length` at end of file, or -1 on error.
+        [[nodiscard]] long readAt(unsigned char* target, std::size_t length, std::uint64_t offset) const noexcept;
+
+        /// NOTE: appends all `length` octets at the current position, or gives false on error.
+        [[nodiscard]] bool writeAll(const unsigned char* source, std::size_t length) noexcept;
+
+        /// NOTE: writes all `length` octets at `offset` without moving the file position, so other threads may write the same file meanwhile.
+        [[nodiscard]] bool writeAt(const unsigned char* source, std::size_t length, std::uint64_t offset) const noexcept;
+
+        /// NOTE: flushes written data to the disk, as `fdatasync` does.
+        [[nodiscard]] bool sync() const noexcept;
+
+        void close() noexcept;
+    };
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+#include <netinet/in.h>
+
+namespace TftpServer::Driver {
+    enum class LogLevel : unsigned char {
+        debug,  // per packet, only built into debug builds
+        info,
+        warn,
+        error
+    };
+
+#if defined(TFTPD_DEBUG_LOGS)
+    inline constexpr auto min_log_level = LogLevel::debug;
+#else
+    inline constexpr auto min_log_level = LogLevel::info;
+#endif
+
+    /// NOTE: records are fixed-size, so longer messages get cut off.
+    inline constexpr auto log_text_size = 192UL;
+
+    /// NOTE: records the ring holds before producers start dropping them. Must be a power of two.
+    inline constexpr auto log_ring_capacity = 8192UL;
+
+    inline constexpr auto log_no_worker = ~0U;
+
+    /// NOTE: who a record is about. Zero fields mean no session or peer, and get left out of the line.
+    struct LogOrigin {
+        unsigned int worker;
+        unsigned int session;
+        in_addr_t peer_ip;    // network order
+        in_port_t peer_port;  // network order
+    };
+
+    [[nodiscard]] LogOrigin makeLogOrigin(unsigned int worker, unsigned int session, const sockaddr_in& peer) noexcept;
+
+    struct LogRecord {
+        std::chrono::system_clock::time_point stamp;
+        LogOrigin origin;
+        LogLevel level;
+        std::size_t text_length;
+        char text[log_text_size];
+    };
+
+    /**
+     * @brief Lock-free multi-producer ring of log records, drained by a background thread which formats and writes them in batches. Producers only format the message body into a cell, so logging never takes a lock or makes a syscall on the hot path. When the ring is full, records get dropped and counted instead.
+     */
+    class AsyncLogger {
+    private:
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            LogRecord record;
+        };
+
+        std::unique_ptr<Cell[]> m_cells;
+        alignas(64) std::atomic<std::size_t> m_enqueue_pos;
+        alignas(64) std::size_t m_dequeue_pos;  // only touched by the drain thread
+        std::atomic<std::uint64_t> m_dropped;
+        alignas(64) std::atomic<bool> m_idle;  // the drain thread waits on it, so the first record into an empty ring has to wake it
+        int m_fd;
+        std::jthread m_thread;  // last, so it starts after and stops before the members it uses
+
+        [[nodiscard]] Cell* claimCell() noexcept;
+        void publishCell(Cell* cell) noexcept;
+        void wakeDrain() noexcept;
+        [[nodiscard]] bool hasReadyCell() const noexcept;
+        [[nodiscard]] std::size_t drainBatch(std::string& lines);
+        void runDrain(std::stop_token stop_token);
+
+    public:
+        explicit AsyncLogger(int fd);
+        ~AsyncLogger();
+
+        AsyncLogger(const AsyncLogger& other) = delete;
+        AsyncLogger& operator=(const AsyncLogger& other) = delete;
+
+        template <typename... Args>
+        void push(LogLevel level, const LogOrigin& origin, std::format_string<Args...> fmt, Args&&... args) noexcept {
+            auto* cell = claimCell();
+
+            if (cell == nullptr) {
+                return;
+            }
+
+            auto& record = cell->record;
+            record.stamp = std::chrono::system_clock::now();
+            record.origin = origin;
+            record.level = level;
+
+            try {
+                record.text_length = static_cast<std::size_t>(std::format_to_n(record.text, log_text_size, fmt, std::forward<Args>(args)...).out - record.text);
+            } catch (...) {
+                record.text_length = 0;
+            }
+
+            publishCell(cell);
+        }
+    };
+
+    void setActiveLogger(AsyncLogger* logger) noexcept;
+    [[nodiscard]] AsyncLogger* getActiveLogger() noexcept;
+
+    /// NOTE: formats the whole line, as the drain thread does for records it takes off the ring.
+    void appendLogLine(std::string& lines, const LogRecord& record);
+
+    /// NOTE: writes one record right away, for when no logger runs, such as before startup finished.
+    void writeLogNow(const LogRecord& record) noexcept;
+
+    /**
+     * @brief Logs through the active logger, or synchronously when none runs. Calls below `min_log_level` compile to nothing.
+     */
+    template <LogLevel Level, typename... Args>
+    void logEvent(const LogOrigin& origin, std::format_string<Args...> fmt, Args&&... args) noexcept {
+        if constexpr (Level >= min_log_level) {
+            if (auto* logger = getActiveLogger(); logger != nullptr) {
+                logger->push(Level, origin, fmt, std::forward<Args>(args)...);
+                return;
+            }
+
+            LogRecord record {std::chrono::system_clock::now(), origin, Level, 0, {}};
+
+            try {
+                record.text_length = static_cast<std::size_t>(std::format_to_n(record.text, log_text_size, fmt, std::forward<Args>(args)...).out - record.text);
+            } catch (...) {
+                return;
+            }
+
+            writeLogNow(record);
+        }
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "mytftp/types.hpp"
+
+namespace TftpServer::Driver {
+    class FileCache;
+    class PacketCache;
+
+    using MetricCounter = std::atomic<std::uint64_t>;
+
+    /// NOTE: each counter has one writing thread, so a plain load and store does instead of a locked add. Readers on other threads may see it a moment late.
+    inline void bumpCounter(MetricCounter& counter, std::uint64_t amount = 1UL) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    inline constexpr auto max_histogram_buckets = 16UL;
+
+    /// NOTE: upper bounds of the ACK round-trip buckets, from loopback up to slow WAN paths.
+    inline constexpr std::array<std::uint64_t, 14> ack_rtt_bounds_ns = {
+        50'000, 100'000, 250'000, 500'000,
+        1'000'000, 2'500'000, 5'000'000, 10'000'000, 25'000'000, 50'000'000, 100'000'000, 250'000'000, 500'000'000,
+        1'000'000'000
+    };
+
+    inline constexpr std::array<std::uint64_t, 10> transfer_duration_bounds_ns = {
+        1'000'000, 10'000'000, 100'000'000, 500'000'000,
+        1'000'000'000, 5'000'000'000, 10'000'000'000, 30'000'000'000, 60'000'000'000, 300'000'000'000
+    };
+
+    /**
+     * @brief Histogram of durations over fixed buckets, recorded by one thread and read by any.
+     */
+    class LatencyHistogram {
+    private:
+        std::span<const std::uint64_t> m_bounds_ns;
+        std::array<MetricCounter, max_histogram_buckets + 1> m_buckets;  // one past the bounds for +Inf
+        MetricCounter m_sum_ns;
+        MetricCounter m_count;
+
+    public:
+        explicit LatencyHistogram(std::span<const std::uint64_t> bounds_ns) noexcept;
+
+        LatencyHistogram(const LatencyHistogram& other) = delete;
+        LatencyHistogram& operator=(const LatencyHistogram& other) = delete;
+
+        void record(std::chrono::nanoseconds value) noexcept;
+
+        /// NOTE: appends the `_bucket`, `_sum`, and `_count` series, with `labels` inside each series' braces.
+        void render(std::string& out, std::string_view name, std::string_view labels) const;
+    };
+
+    /**
+     * @brief Counters of one worker. Only that worker's thread writes them, so recording never contends with other workers.
+     */
+    struct alignas(64) WorkerMetrics {
+        MetricCounter packets_in;
+        MetricCounter packets_out;
+        MetricCounter data_bytes_out;  // DATA payload octets sent for RRQ, re-sends included
+        MetricCounter data_bytes_in;   // DATA payload octets stored for WRQ
+        MetricCounter retransmits;
+        MetricCounter active_sessions;
+        std::array<MetricCounter, static_cast<std::size_t>(MyTftp::ErrorCode::last) + 1> errors_sent;
+        LatencyHistogram ack_rtt;
+        LatencyHistogram rrq_durations;
+        LatencyHistogram wrq_durations;
+
+        WorkerMetrics() noexcept;
+    };
+
+    /**
+     * @brief Owns every worker's metrics for the whole run, so the exporter may read them until it stops.
+     */
+    class MetricsRegistry {
+    private:
+        std::vector<std::unique_ptr<WorkerMetrics>> m_workers;
+        const FileCache* m_file_cache;      // shared by all workers, so its series carry no worker label
+        const PacketCache* m_packet_cache;  // null unless the packet cache is enabled
+
+        void renderCaches(std::string& out) const;
+
+    public:
+        /// NOTE: the caches must outlive the registry's last `render` call.
+        MetricsRegistry(std::size_t worker_count, const FileCache* file_cache = nullptr, const PacketCache* packet_cache = nullptr);
+
+        MetricsRegistry(const MetricsRegistry& other) = delete;
+        MetricsRegistry& operator=(const MetricsRegistry& other) = delete;
+
+        [[nodiscard]] WorkerMetrics& getWorker(std::size_t worker_index) noexcept;
+
+        /// NOTE: Prometheus text exposition format, version 0.0.4.
+        [[nodiscard]] std::string render() const;
+    };
+
+    /**
+     * @brief Background thread which rewrites a metrics file every period, for node_exporter's textfile collector or anything else which scrapes files. Each write goes to a temporary file renamed over the old one, so readers never see half a file.
+     */
+    class MetricsExporter {
+    private:
+        std::string m_path;
+        std::string m_temp_path;
+        const MetricsRegistry& m_registry;
+        std::mutex m_mutex;
+        std::condition_variable_any m_wakeup;
+        std::jthread m_thread;  // last, so it starts after and stops before the members it uses
+
+        [[nodiscard]] bool writeOnce() const;
+        void runExport(std::stop_token stop_token);
+
+    public:
+        MetricsExporter(std::string path, const MetricsRegistry& registry);
+
+        MetricsExporter(const MetricsExporter& other) = delete;
+        MetricsExporter& operator=(const MetricsExporter& other) = delete;
+    };
+}
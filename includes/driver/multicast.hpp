@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <netinet/in.h>
+#include "mytftp/types.hpp"
+#include "driver/config.hpp"
+
+namespace TftpServer::Driver {
+    class Session;
+
+    /// NOTE: where one multicast transfer streams its DATA, as leased from its worker's registry.
+    struct MulticastGroup {
+        sockaddr_in address;
+        std::size_t slot;
+    };
+
+    /**
+     * @brief Leases one worker's RFC 2090 groups to read transfers, and tracks which transfer streams which file, so later requests for that file join it instead of starting their own.
+     */
+    class MulticastRegistry {
+    private:
+        std::unordered_map<std::string, Session*> m_transfers;  // by filename
+        std::vector<bool> m_leased;  // by slot
+        in_addr_t m_first_group;  // host order
+        in_port_t m_port;         // network order
+        in_addr_t m_interface;    // network order
+
+    public:
+        MulticastRegistry(const ServerConfig& config, unsigned int worker_id);
+
+        MulticastRegistry(const MulticastRegistry& other) = delete;
+        MulticastRegistry& operator=(const MulticastRegistry& other) = delete;
+
+        [[nodiscard]] bool isEnabled() const noexcept;
+        [[nodiscard]] in_addr_t getInterface() const noexcept;
+
+        /// NOTE: gives the live transfer which an octet RRQ asking for multicast may join, or null when it has to start its own.
+        [[nodiscard]] Session* findTransfer(const MyTftp::RWPayload& request) const;
+
+        /// NOTE: gives nothing when every group is leased or another transfer already streams the file, so the session serves its peer by unicast.
+        [[nodiscard]] std::optional<MulticastGroup> lease(const std::string& filename, Session& session);
+        void release(const MulticastGroup& group, const Session& session) noexcept;
+    };
+}
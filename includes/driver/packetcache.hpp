@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include "driver/files.hpp"
+#include "driver/filecache.hpp"
+
+namespace TftpServer::Driver {
+    /// NOTE: only files up to this size get encoded, as larger ones would crowd out the many small ones this cache is for.
+    inline constexpr auto packet_cache_max_file = 1024UL * 1024UL;
+
+    /// NOTE: misses waiting for the builder thread, beyond which further ones just get served uncached.
+    inline constexpr auto packet_cache_max_queued = 16UL;
+
+    struct PacketCacheStats {
+        std::uint64_t hits;    // transfers served from packets already encoded
+        std::uint64_t misses;  // transfers of cacheable files which read through the normal path
+        std::uint64_t builds;  // files encoded after a miss
+        std::uint64_t bytes_resident;
+        std::uint64_t evictions;
+        std::uint64_t files;
+    };
+
+    /**
+     * @brief Every DATA message of one file at one block size, encoded back to back. It never changes once built, so sessions of any thread hand its packets to the kernel as they are.
+     */
+    class EncodedFile {
+    private:
+        std::unique_ptr<unsigned char[]> m_packets;  // block i's message starts at (i - 1) x the full packet size
+        FileIdentity m_identity;
+        std::size_t m_block_size;
+        std::uint64_t m_block_count;  // including the short or empty final block
+
+    public:
+        EncodedFile(const FileIdentity& identity, std::size_t block_size);
+
+        EncodedFile(const EncodedFile& other) = delete;
+        EncodedFile& operator=(const EncodedFile& other) = delete;
+
+        /// NOTE: reads and encodes the whole file, or gives false when it could not be read in full.
+        [[nodiscard]] bool encode(const FileHandle& source) noexcept;
+
+        [[nodiscard]] const FileIdentity& getIdentity() const noexcept;
+        [[nodiscard]] std::size_t getBlockSize() const noexcept;
+        [[nodiscard]] std::uint64_t getBlockCount() const noexcept;
+        [[nodiscard]] std::size_t getEncodedSize() const noexcept;
+
+        /// NOTE: `block_index` is the absolute block no. from 1 through `getBlockCount()`.
+        [[nodiscard]] std::span<const unsigned char> getPacket(std::uint64_t block_index) const noexcept;
+    };
+
+    /**
+     * @brief Shared cache of encoded small files keyed by request path and block size, bounded by a memory cap with LRU eviction. Evicted entries stay alive for sessions still holding them. Misses get encoded by a background thread, so no worker's reactor ever waits on a whole file.
+     */
+    class PacketCache {
+    private:
+        using LruList = std::list<std::pair<std::string, std::shared_ptr<const EncodedFile>>>;
+
+        struct BuildTask {
+            std::string key;
+            FileHandle file;  // a duplicate, since the requesting session may end first
+            FileIdentity identity;
+            std::size_t block_size;
+        };
+
+        LruList m_lru;  // most recently used first
+        std::unordered_map<std::string, LruList::iterator> m_index;
+        std::deque<BuildTask> m_tasks;
+        std::unordered_set<std::string> m_queued_keys;  // of queued or running builds, so a popular miss gets encoded once
+        std::atomic<std::uint64_t> m_hits;
+        std::atomic<std::uint64_t> m_misses;
+        std::atomic<std::uint64_t> m_builds;
+        std::atomic<std::uint64_t> m_evictions;
+        mutable std::mutex m_mutex;
+        std::condition_variable_any m_wakeup;
+        std::size_t m_capacity;
+        std::size_t m_used;
+        std::jthread m_thread;  // last, so it starts after and stops before the members it uses
+
+        void insert(const std::string& key, std::shared_ptr<const EncodedFile> encoded);
+        void runBuilder(std::stop_token stop_token);
+        void runTask(BuildTask& task);
+
+    public:
+        explicit PacketCache(std::size_t capacity);
+
+        PacketCache(const PacketCache& other) = delete;
+        PacketCache& operator=(const PacketCache& other) = delete;
+
+        /// NOTE: gives null for files too large, unreadable, or not regular. A miss gives null too, and queues the file for the builder thread, so that transfer reads through the normal path and later ones get the packets.
+        [[nodiscard]] std::shared_ptr<const EncodedFile> acquire(const std::string& path, const FileHandle& file, std::size_t block_size);
+
+        [[nodiscard]] PacketCacheStats getStats() const;
+    };
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include "driver/filecache.hpp"
+
+namespace TftpServer::Driver {
+    /// NOTE: disk reads overlap well past the core count, so warming uses this many threads regardless of workers.
+    inline constexpr auto prewarm_thread_count = 8UL;
+
+    struct PrewarmReport {
+        std::size_t files;          // matched by the manifest
+        std::size_t cached_files;   // loaded into the shared cache
+        std::size_t locked_files;   // of those, pinned in RAM
+        std::size_t failed_files;   // unreadable ones
+        std::uint64_t bytes_read;
+        std::uint64_t bytes_locked;
+        std::chrono::milliseconds elapsed;
+    };
+
+    /**
+     * @brief Reads every file a manifest names into memory before the server takes requests. The manifest lists one path or glob per line relative to the served directory, hottest first, where blank lines and `#` comments get skipped.
+     * @note Files load into the shared cache in manifest order while they fit its cap, and the first ones also get mlocked while `lock_bytes` lasts. The rest only land in the page cache. Gives nothing when the manifest cannot be read.
+     */
+    [[nodiscard]] std::optional<PrewarmReport> prewarmFiles(const char* manifest_path, FileCache& cache, std::size_t cache_bytes, std::size_t lock_bytes);
+}
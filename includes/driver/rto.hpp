@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+
+namespace TftpServer::Driver {
+    using RtoDuration = std::chrono::steady_clock::duration;
+
+    /// NOTE: resolution of session timers, which is also the least variance margin an RTO keeps over the smoothed RTT.
+    inline constexpr auto rto_granularity = std::chrono::milliseconds {10};
+
+    /// NOTE: RTO before the first RTT sample, as RFC 6298 advises.
+    inline constexpr auto rto_initial = std::chrono::seconds {1};
+
+    inline constexpr auto rto_min = std::chrono::milliseconds {20};
+    inline constexpr auto rto_max = std::chrono::seconds {10};
+
+    /**
+     * @brief Retransmission timeout of one transfer, estimated from its round trips as in RFC 6298 (Jacobson's smoothed RTT and variance). Timeouts double it until a fresh sample comes in.
+     */
+    class RetransmitTimer {
+    private:
+        RtoDuration m_srtt;
+        RtoDuration m_rttvar;
+        RtoDuration m_rto;
+        bool m_sampled;
+        bool m_pinned;  // the peer chose the timeout through RFC 2349, so it never adapts
+
+        void updateTimeout() noexcept;
+
+    public:
+        RetransmitTimer() noexcept;
+
+        void pin(RtoDuration timeout) noexcept;
+
+        /// NOTE: per Karn's algorithm, callers only pass round trips of replies that went out once, as those of re-sent ones are ambiguous.
+        void addSample(RtoDuration rtt) noexcept;
+
+        void backOff() noexcept;
+
+        [[nodiscard]] RtoDuration getTimeout() const noexcept;
+        [[nodiscard]] RtoDuration getSmoothedRtt() const noexcept;
+    };
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <vector>
+#include <netinet/in.h>
+#include "driver/config.hpp"
+
+namespace TftpServer::Driver {
+    class Session;
+
+    using SchedulerClock = std::chrono::steady_clock;
+
+    /// NOTE: octets a session may send per round-robin turn. Small enough that a short file's blocks go out within a few turns behind any number of large ones.
+    inline constexpr auto schedule_quantum = 16UL * 1024UL;
+
+    /**
+     * @brief Classic token bucket over octets, refilled lazily from the clock. A zero rate means unlimited.
+     */
+    class TokenBucket {
+    private:
+        SchedulerClock::time_point m_refilled_at;
+        std::size_t m_rate;   // octets per second
+        std::size_t m_burst;  // most octets it holds
+        std::size_t m_tokens;
+
+    public:
+        TokenBucket() noexcept;
+        explicit TokenBucket(std::size_t rate) noexcept;
+
+        [[nodiscard]] bool isLimited() const noexcept;
+        void refill(SchedulerClock::time_point now) noexcept;
+        [[nodiscard]] std::size_t getTokens() const noexcept;
+        void take(std::size_t amount) noexcept;
+    };
+
+    /// NOTE: a session's own scheduling state, kept in the session so that nothing outlives it.
+    struct SendFlow {
+        TokenBucket bucket;
+        std::optional<std::size_t> class_index;  // into the scheduler's subnet classes
+        std::size_t deficit;
+        std::optional<std::size_t> entry;  // into the scheduler's ready entries while queued
+    };
+
+    /**
+     * @brief Paces the DATA of one worker's read transfers. Sessions with blocks ready queue up here and take turns by deficit round robin, each turn bounded by the session's, its subnet class's, and the worker's token buckets. The global and class rates get split evenly across workers, so no bucket is shared between threads.
+     */
+    class SendScheduler {
+    private:
+        struct ClassBucket {
+            in_addr_t network;  // network order
+            in_addr_t mask;     // network order
+            TokenBucket bucket;
+        };
+
+        std::deque<std::size_t> m_ready;  // entry indices in turn order
+        std::vector<Session*> m_entries;  // null once the session cancelled, until its index comes up in turn
+        std::vector<std::size_t> m_free_entries;
+        std::vector<ClassBucket> m_classes;
+        TokenBucket m_global;
+        std::size_t m_session_rate;
+
+        void leave(std::size_t entry_index, SendFlow& flow) noexcept;
+
+    public:
+        SendScheduler(const ServerConfig& config);
+
+        SendScheduler(const SendScheduler& other) = delete;
+        SendScheduler& operator=(const SendScheduler& other) = delete;
+
+        /// NOTE: without any configured rate, sessions send their windows directly and never come here.
+        [[nodiscard]] bool isLimited() const noexcept;
+
+        /// NOTE: the first listed class containing the peer applies, so narrower subnets go before the wider ones holding them.
+        [[nodiscard]] SendFlow makeFlow(const sockaddr_in& peer) const noexcept;
+
+        void enqueue(Session& session, SendFlow& flow);
+
+        /// NOTE: O(1), for a session going away. Its entry stays in line, emptied, and `service` drops it once it comes up.
+        void cancel(SendFlow& flow) noexcept;
+
+        /// NOTE: runs turns until every queued session either ran dry or waits on a bucket. Called after each batch of reactor events and on every tick. Sessions which ended during their turn get added to `finished`.
+        void service(SchedulerClock::time_point now, std::vector<Session*>& finished);
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include "mybsock/buffers.hpp"
+#include "mybsock/sockets.hpp"
+#include "mybsock/reactor.hpp"
+#include "mybsock/ioring.hpp"
+#include "mybsock/pools.hpp"
+#include "mytftp/types.hpp"
+#include "driver/config.hpp"
+#include "driver/multicast.hpp"
+#include "driver/scheduler.hpp"
+#include "driver/session.hpp"
+#include "driver/sessiontable.hpp"
+#include "driver/timerwheel.hpp"
+
+namespace TftpServer::Driver {
+    [[nodiscard]] MyBSock::UDPServerSocket makeUDPSocket(const char* port_cstr, bool reuse_port = false);
+
+    /// NOTE: most requests the listener takes per `recvmmsg` call.
+    inline constexpr auto request_batch_size = 16UL;
+
+    struct ReadResult {
+        MyTftp::Message msg;
+        MyBSock::IOResult io_data;
+    };
+
+    /**
+     * @brief Accepts RRQ / WRQ requests on the listening socket and runs each accepted transfer as its own session on an ephemeral port. All sockets are multiplexed by one reactor, so one server runs on one thread.
+     */
+    class MyServer {
+    private:
+        std::unique_ptr<MyBSock::IoRing> m_ring;  // declared before the sessions, which give their buffers back when destroyed
+        MyBSock::PacketPool m_packet_pool;
+        SendScheduler m_scheduler;  // declared before the sessions, which leave its queue when destroyed
+        MulticastRegistry m_multicast;  // declared before the sessions, which give their groups back when destroyed
+        TimerWheel m_timers;  // declared before the sessions, which cancel their timers when destroyed
+        MyBSock::ObjectSlab<Session> m_session_slab;
+        SessionTable m_sessions;  // live transfers by peer TID
+        std::vector<Session*> m_finished;  // sessions which ended since the last reaping, maybe listed more than once
+        SessionResources m_resources;
+        MyBSock::Reactor m_reactor;
+        std::array<MyBSock::FixedBuffer<MyTftp::tftp_u8, io_buffer_size>, request_batch_size> m_request_buffers;
+        MyBSock::DatagramBatch<request_batch_size> m_request_batch;
+        MyBSock::FixedBuffer<MyTftp::tftp_u8, io_buffer_size> m_buffer;  // for error replies
+        MyBSock::UDPServerSocket m_socket;  // listens for requests only
+        std::size_t m_max_sessions;
+        unsigned int m_next_session_id;
+        unsigned int m_worker_id;
+        bool m_ticking;
+
+        void readRequests();
+        void handleRequest(const ReadResult& read_result);
+        void sendError(MyTftp::ErrorCode error_code, const MyBSock::IOResult& prev_io);
+        void noteFinished(Session& session);
+        void expireTimers();
+        void reapSessions();
+        void updateTicks();
+        void reportFootprint(const ServerConfig& config) const;
+
+    public:
+        MyServer() = delete;
+        /// NOTE: falls back to the epoll backend when the kernel refuses an io_uring.
+        MyServer(MyBSock::UDPServerSocket socket, const SessionResources& resources, unsigned int worker_id, const ServerConfig& config);
+
+        MyServer(const MyServer& other) = delete;
+        MyServer& operator=(const MyServer& other) = delete;
+
+        /// NOTE: safe to call from a signal handler.
+        void requestStop() const noexcept;
+
+        [[nodiscard]] bool runService();
+    };
+}
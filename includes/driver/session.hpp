@@ -0,0 +1,259 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include "mybsock/buffers.hpp"
+#include "mybsock/sockets.hpp"
+#include "mybsock/ioring.hpp"
+#include "mybsock/reactor.hpp"
+#include "mybsock/pools.hpp"
+#include "mytftp/types.hpp"
+#include "mytftp/messaging.hpp"
+#include "mytftp/views.hpp"
+#include "mytftp/netascii.hpp"
+#include "mytftp/options.hpp"
+#include "driver/files.hpp"
+#include "driver/filecache.hpp"
+#include "driver/multicast.hpp"
+#include "driver/packetcache.hpp"
+#include "driver/rto.hpp"
+#include "driver/scheduler.hpp"
+#include "driver/timerwheel.hpp"
+#include "driver/writer.hpp"
+#include "driver/logging.hpp"
+#include "driver/metrics.hpp"
+
+namespace TftpServer::Driver {
+    using SessionClock = TimerClock;
+
+    /// NOTE: RFC 2347 caps request messages at 512B, so the listener never needs the full block-sized buffer.
+    inline constexpr auto io_buffer_size = 1024UL;
+
+    /// NOTE: a peer which stays silent through this many retransmits is dropped. With the RTO doubling each time, that takes at least ~10s.
+    inline constexpr auto session_max_retries = 8U;
+
+    /// NOTE: server cap on the RFC 7440 window, so one peer cannot keep an unbounded run of blocks in flight.
+    inline constexpr auto session_max_window = 64UL;
+
+    /// NOTE: most datagrams a session moves per `recvmmsg` or `sendmmsg` call. Larger windows go out in several batches.
+    inline constexpr auto session_batch_size = 16UL;
+
+    /// NOTE: most clients waiting on one multicast transfer besides its master. Requests past it get served by unicast.
+    inline constexpr auto multicast_max_members = 256UL;
+
+    extern const std::array<std::string, static_cast<std::size_t>(MyTftp::ErrorCode::last) + 1> server_error_msgs;
+
+    /// NOTE: RFC 1350 identifies a transfer's peer by its address and port, so both form the lookup key of a session.
+    struct PeerKey {
+        in_addr_t ip;
+        in_port_t port;
+
+        [[nodiscard]] friend constexpr bool operator==(const PeerKey& lhs, const PeerKey& rhs) noexcept = default;
+    };
+
+    struct PeerKeyHash {
+        [[nodiscard]] std::size_t operator()(const PeerKey& key) const noexcept;
+    };
+
+    [[nodiscard]] PeerKey makePeerKey(const sockaddr_in& address) noexcept;
+
+    template <MyBSock::OctetBuffer Buffer>
+    bool sendErrorTo(MyBSock::UDPServerSocket& socket, Buffer& buffer, MyTftp::ErrorCode error_code, const MyBSock::IOResult& target) {
+        const auto error_msg_id = static_cast<MyTftp::tftp_u16>(error_code);
+
+        buffer.reset();
+
+        if (not MyTftp::serializeMessage(buffer, MyTftp::Message {
+            MyTftp::Opcode::err,
+            MyTftp::ErrorPayload {
+                .error = error_code,
+                .message = server_error_msgs[error_msg_id]
+            }
+        })) {
+            return false;
+        }
+
+        return socket.sendTo(buffer, buffer.getLength(), target).status == MyBSock::IOStatus::ok;
+    }
+
+    /// NOTE: services shared by all sessions of a server. Each pointer may be null when its feature is off.
+    struct SessionResources {
+        FileCache* file_cache;
+        PacketCache* packet_cache;         // shared by all workers, or null when off
+        MyBSock::IoRing* io_ring;          // of the worker running the session
+        MyBSock::PacketPool* packet_pool;  // of the worker running the session, and never null
+        FileWriter* file_writer;           // shared by all workers
+        WorkerMetrics* metrics;            // of the worker running the session, and never null
+        SendScheduler* scheduler;          // of the worker running the session, or null when no rate is set
+        MulticastRegistry* multicast;      // of the worker running the session, or null when multicast is off
+        TimerWheel* timers;                // of the worker running the session, and never null
+        MyBSock::Reactor* reactor;         // of the worker running the session, and never null
+        unsigned int worker_id;            // of the worker running the session, for log lines
+    };
+
+    using PacketSlot = MyBSock::SpanBuffer<MyTftp::tftp_u8>;
+
+    /// NOTE: packet buffers carved out of one pooled run, sized once the transfer options are known. Each slot starts on its own cache line.
+    struct PacketSlots {
+        MyBSock::PacketRun run;
+        std::array<PacketSlot, session_batch_size> slots;
+        std::size_t count;
+    };
+
+    [[nodiscard]] std::optional<PacketSlots> makePacketSlots(MyBSock::PacketPool& pool, std::size_t slot_count, std::size_t slot_size) noexcept;
+
+    /// NOTE: pooled octets one transfer holds with the given options, which bounds the server's footprint as sessions x this.
+    [[nodiscard]] std::size_t estimatePacketBytes(MyTftp::Opcode op, MyTftp::DataMode mode, std::size_t block_size, std::size_t window_size) noexcept;
+
+    /// NOTE: netascii blocks do not map to fixed file offsets, so each block in flight remembers where its octets start and which pair half it owes first.
+    struct NetasciiCursor {
+        std::uint64_t offset;
+        MyTftp::NetasciiCarry carry;
+    };
+
+    /// NOTE: the reply whose answer yields the next RTT sample: for RRQ, the ACK of block `index`, and for WRQ, the DATA after it.
+    struct RttProbe {
+        std::uint64_t index;
+        SessionClock::time_point sent_at;
+    };
+
+    /// NOTE: a client of a multicast transfer which listens to the group until its turn as master comes.
+    struct MulticastMember {
+        MyBSock::IOResult peer;
+        MyTftp::OptionList accepted;  // its OACK without the `multicast` entry
+        std::size_t window_size;
+    };
+
+    struct TransferContext {
+        FileHandle file;  // read-only for RRQ, write-only for WRQ
+        MyTftp::tftp_u16 block;
+        bool done;
+    };
+
+    /**
+     * @brief Holds the state of one RRQ or WRQ transfer. Each session owns an ephemeral-port socket which serves as the server's transfer ID for that peer.
+     * @note An RFC 2090 multicast RRQ sends its DATA to a group instead, paced by the ACKs of one master client. `m_peer` then names the current master, and the other clients wait as members.
+     */
+    class Session {
+    private:
+        TransferContext m_ctx;  // for WRQ, `block` is the last in-order block received
+        SessionResources& m_resources;
+        std::shared_ptr<CachedFile> m_cached;  // for RRQ, when the file is served from the shared cache
+        std::shared_ptr<const EncodedFile> m_encoded;  // for octet RRQ, when its DATA messages come pre-encoded
+        std::optional<UploadStream> m_upload;  // for WRQ, when blocks get written behind by the file writer
+        PacketSlots m_rx_slots;  // for RRQ, sized for ACKs, and for WRQ, for DATA
+        PacketSlots m_tx_slots;  // for RRQ, one DATA message per block of a send batch
+        PacketSlots m_ascii_slots;  // for netascii, one slot of file octets before or after translation
+        std::array<NetasciiCursor, session_max_window + 1> m_ascii_cursors;  // for netascii RRQ, indexed by a block's absolute no. modulo the size
+        MyTftp::NetasciiCarry m_ascii_carry;  // for netascii WRQ
+        MyBSock::DatagramBatch<session_batch_size> m_rx_batch;
+        MyBSock::DatagramBatch<session_batch_size> m_tx_batch;
+        MyBSock::FixedBuffer<MyTftp::tftp_u8, io_buffer_size> m_tx_buffer;  // keeps the last OACK, ACK, or ERROR for re-sending
+        MyBSock::UDPServerSocket m_socket;
+        MyBSock::IOResult m_peer;
+        std::optional<MulticastGroup> m_group;     // for multicast RRQ
+        std::deque<MulticastMember> m_members;     // for multicast RRQ: the clients next in line as master
+        SessionClock::time_point m_started_at;
+        SessionClock::time_point m_retry_deadline;
+        TimerNode m_timer;  // fires at `m_retry_deadline`
+        PeerKey m_key;      // of the first peer, which the worker's session table files this session under
+        RetransmitTimer m_rto;
+        std::optional<RttProbe> m_rtt_probe;
+        SendFlow m_flow;
+        std::size_t m_block_size;
+        std::size_t m_window_size;
+        std::uint64_t m_acked_index;    // for RRQ: absolute no. of the last block the peer ACKed
+        std::uint64_t m_sent_index;     // for RRQ: absolute no. of the last block sent
+        std::uint64_t m_last_index;     // for RRQ: absolute no. of the short final block, or 0 if not read yet
+        std::uint64_t m_pending_index;  // for paced RRQ: absolute no. of the next block waiting for its turn
+        std::uint64_t m_pending_end;    // for paced RRQ: one past the last block waiting, so equal to `m_pending_index` when none wait
+        std::optional<std::uint64_t> m_file_size;   // for RRQ, which lets ring reads know each block's length up front
+        std::optional<unsigned int> m_ring_buffer;  // for RRQ: `m_tx_slots` as registered with the io_uring
+        std::bitset<session_batch_size> m_ring_linked;  // for RRQ with a ring: the send batch slots whose sends already wait on their reads
+        std::size_t m_window_received;  // for WRQ: in-order blocks received since the last ACK
+        MyTftp::Opcode m_request_op;
+        MyTftp::DataMode m_mode;
+        unsigned int m_id;
+        unsigned int m_retries;
+        bool m_gap_reported;  // for WRQ: the ACK asking the peer to resume after a lost block already went out
+        bool m_resume_pending;  // for RRQ: an ACK of the current batch asks for the window after it
+        bool m_store_pending;   // for WRQ: the last block came in, and its ACK waits until the writer synced the file
+        bool m_awaiting_writable;  // for RRQ: the socket buffer filled up, and the rest of the send batch waits for room
+
+        [[nodiscard]] bool writeNextFileChunk(MyTftp::OctetSpan chunk, bool last_chunk);
+        [[nodiscard]] long readNetasciiBlock(std::uint64_t block_index, MyTftp::tftp_u8* target);
+        [[nodiscard]] bool openTransferFile(MyTftp::Opcode op, const std::string& filename);
+        [[nodiscard]] std::size_t findBlockSizeLimit() const;
+        [[nodiscard]] bool hasSpaceFor(const std::string& filename, std::uintmax_t transfer_size) const;
+        [[nodiscard]] bool prepareSlots();
+
+        void startRttProbe(std::uint64_t index);
+        void finishRttProbe(std::uint64_t index);
+
+        void handleMessage(const MyTftp::MessageView& msg, const MyBSock::IOResult& io_result);
+        [[nodiscard]] bool handleMemberMessage(const MyTftp::MessageView& msg, const MyBSock::IOResult& io_result);
+        [[nodiscard]] std::deque<MulticastMember>::iterator findMember(const PeerKey& peer_key);
+        [[nodiscard]] MyTftp::OptionList addMulticastOption(MyTftp::OptionList accepted, bool master) const;
+        [[nodiscard]] const sockaddr_in& getDataTarget() const noexcept;
+        void sendMemberOAck(const MulticastMember& member);
+        void promoteNextMember();
+        void sendOAck(const MyTftp::OptionList& accepted);
+        void sendWindow(std::uint64_t first_index);
+        [[nodiscard]] std::size_t sendBlocks(std::uint64_t first_index, std::size_t block_count);
+        [[nodiscard]] std::size_t sendEncodedBlocks(std::uint64_t first_index, std::size_t block_count);
+        void flushWindow();
+        void pushBatch();
+        void watchWritable(bool writable) noexcept;
+        void flushWindowRing();
+        void dropWindow();
+        void sendDataMessage(const MyTftp::AckView& ack);
+        void sendAckMessage();
+        void sendAck(const MyTftp::DataView& data);
+        void finishUpload();
+        void sendError(MyTftp::ErrorCode error_code, const MyBSock::IOResult& target);
+        void sendReply();
+        void retransmit();
+        void armRetry(SessionClock::time_point deadline) noexcept;
+
+    public:
+        Session() = delete;
+        Session(unsigned int id, MyBSock::UDPServerSocket socket, const MyBSock::IOResult& peer, SessionResources& resources) noexcept;
+
+        ~Session();
+
+        Session(const Session& other) = delete;
+        Session& operator=(const Session& other) = delete;
+
+        [[nodiscard]] unsigned int getId() const noexcept;
+        [[nodiscard]] int getFd() const noexcept;
+        [[nodiscard]] const PeerKey& getKey() const noexcept;
+        [[nodiscard]] bool isDone() const noexcept;
+
+        [[nodiscard]] SendFlow& getFlow() noexcept;
+        [[nodiscard]] bool hasPendingBlocks() const noexcept;
+        [[nodiscard]] std::size_t getBlockPacketSize() const noexcept;
+
+        /// NOTE: sends as many whole blocks of the waiting window as `byte_budget` covers, and gives the octets that went out.
+        std::size_t sendPendingBlocks(std::size_t byte_budget);
+
+        void start(const MyTftp::Message& request);
+
+        /// NOTE: lets another client's RRQ join this multicast transfer, or gives false when it cannot, e.g. for needing smaller blocks.
+        [[nodiscard]] bool addMember(const MyTftp::Message& request, const MyBSock::IOResult& peer);
+
+        void onReadable();
+
+        /// NOTE: sends what a full socket buffer held back of the last batch.
+        void onWritable();
+        void onRepeatedRequest();
+
+        /// NOTE: called by the worker's timer wheel once the retry deadline passes. Re-sends the unanswered reply, or ends the session after too many tries.
+        void onTick(SessionClock::time_point now);
+    };
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "mybsock/pools.hpp"
+#include "driver/session.hpp"
+
+namespace TftpServer::Driver {
+    /**
+     * @brief Open-addressing table of one worker's live sessions keyed by peer address and port. Probing is linear over a power-of-two array at most half full, and deletion shifts the rest of a probe run back instead of leaving tombstones, so lookups stay short no matter how many sessions came and went.
+     */
+    class SessionTable {
+    public:
+        using Handle = MyBSock::ObjectSlab<Session>::Handle;
+
+    private:
+        struct Record {
+            PeerKey key;
+            Handle session;  // null in free slots
+        };
+
+        std::vector<Record> m_records;
+        std::size_t m_mask;
+        std::size_t m_count;
+
+        [[nodiscard]] std::size_t toHome(const PeerKey& key) const noexcept;
+        [[nodiscard]] std::size_t findIndex(const PeerKey& key) const noexcept;
+        void eraseAt(std::size_t index) noexcept;
+
+    public:
+        /// NOTE: sized once for `max_entries`, which the server's session cap guarantees is never passed.
+        explicit SessionTable(std::size_t max_entries);
+
+        SessionTable(const SessionTable& other) = delete;
+        SessionTable& operator=(const SessionTable& other) = delete;
+
+        [[nodiscard]] std::size_t getSize() const noexcept;
+        [[nodiscard]] bool isEmpty() const noexcept;
+
+        [[nodiscard]] Session* find(const PeerKey& key) const noexcept;
+
+        /// NOTE: gives false when the key is taken or the table is full, and `session` then gets destroyed.
+        [[nodiscard]] bool insert(const PeerKey& key, Handle session);
+
+        /// NOTE: gives false when no session runs for `key`.
+        bool erase(const PeerKey& key) noexcept;
+    };
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "driver/rto.hpp"
+
+namespace TftpServer::Driver {
+    class Session;
+
+    using TimerClock = std::chrono::steady_clock;
+
+    /// NOTE: each level has this many slots, and each slot of a level spans all slots of the level below.
+    inline constexpr auto timer_wheel_bits = 6UL;
+    inline constexpr auto timer_wheel_slots = 1UL << timer_wheel_bits;
+    /// NOTE: four levels of 10ms ticks reach ~46h, and farther deadlines wait in the top level until they come in range.
+    inline constexpr auto timer_wheel_levels = 4UL;
+
+    /// NOTE: intrusive link of one pending timer, kept in its owner so scheduling never allocates. An unlinked node points at itself.
+    struct TimerNode {
+        TimerNode* prev;
+        TimerNode* next;
+        Session* session;
+        std::uint64_t expiry;  // in wheel ticks
+
+        TimerNode() noexcept;
+        explicit TimerNode(Session* owner) noexcept;
+
+        TimerNode(const TimerNode& other) = delete;
+        TimerNode& operator=(const TimerNode& other) = delete;
+
+        /// NOTE: O(1), and harmless for a node that is not scheduled.
+        void cancel() noexcept;
+    };
+
+    /**
+     * @brief Hierarchical timing wheel of session timers with `rto_granularity` ticks. Scheduling and cancelling are O(1), and each tick only touches the timers due in it, besides moving one slot of a higher level down every 64 ticks.
+     */
+    class TimerWheel {
+    private:
+        std::array<std::array<TimerNode, timer_wheel_slots>, timer_wheel_levels> m_slots;  // list heads
+        TimerClock::time_point m_origin;
+        std::uint64_t m_current_tick;  // every timer due at or before it already fired
+
+        [[nodiscard]] std::uint64_t toTicks(TimerClock::time_point when, bool round_up) const noexcept;
+        [[nodiscard]] bool isEmpty() const noexcept;
+        void place(TimerNode& node) noexcept;
+        void cascade(std::size_t level) noexcept;
+
+    public:
+        TimerWheel();
+
+        TimerWheel(const TimerWheel& other) = delete;
+        TimerWheel& operator=(const TimerWheel& other) = delete;
+
+        /// NOTE: an idle server stops ticking, so the wheel falls behind the clock. Once it holds no timers, it jumps straight to `now` here instead of `advance` walking every tick it missed.
+        void catchUp(TimerClock::time_point now) noexcept;
+
+        /// NOTE: moves the node if it is already scheduled. It fires on the first tick at or after `deadline`, and never before the next tick.
+        void schedule(TimerNode& node, TimerClock::time_point deadline) noexcept;
+
+        /// NOTE: fires every timer due by `now` in tick order, unlinking each before `on_expired` gets its session. Those may schedule their timers again.
+        template <typename Fn>
+        void advance(TimerClock::time_point now, Fn&& on_expired) {
+            const auto target_tick = toTicks(now, false);
+
+            while (m_current_tick < target_tick) {
+                m_current_tick++;
+
+                for (auto level = 1UL; level < timer_wheel_levels and (m_current_tick & ((1UL << (level * timer_wheel_bits)) - 1UL)) == 0UL; level++) {
+                    cascade(level);
+                }
+
+                auto& head = m_slots[0][m_current_tick & (timer_wheel_slots - 1UL)];
+
+                while (head.next != &head) {
+                    auto* node = head.next;
+
+                    node->cancel();
+                    on_expired(*node->session);
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "driver/config.hpp"
+#include "driver/metrics.hpp"
+#include "driver/session.hpp"
+#include "driver/server.hpp"
+
+namespace TftpServer::Driver {
+    /**
+     * @brief Runs one `MyServer` shard per thread. Each shard has its own `SO_REUSEPORT` listener, reactor, and session table, so the kernel spreads peers across shards and no transfer state is shared between threads.
+     */
+    class WorkerGroup {
+    private:
+        std::vector<std::unique_ptr<MyServer>> m_servers;
+        std::optional<std::size_t> m_first_core;  // worker `i` gets pinned to core `first + i` when set
+
+        [[nodiscard]] bool runWorker(std::size_t worker_index);
+
+    public:
+        WorkerGroup() = delete;
+        /// NOTE: worker `i` records into `metrics.getWorker(i)`, so the registry needs an entry per worker. Throws `std::runtime_error` when a listener cannot bind the port.
+        WorkerGroup(const ServerConfig& config, const SessionResources& resources, MetricsRegistry& metrics);
+
+        WorkerGroup(const WorkerGroup& other) = delete;
+        WorkerGroup& operator=(const WorkerGroup& other) = delete;
+
+        /// NOTE: safe to call from a signal handler.
+        void requestStop() const noexcept;
+
+        /// NOTE: blocks until every worker stopped, and fails if any worker could not set up its sockets.
+        [[nodiscard]] bool runService();
+    };
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+#include "driver/files.hpp"
+
+namespace TftpServer::Driver {
+    /// NOTE: uploads reach the disk in writes of this size, at file offsets which are multiples of it.
+    inline constexpr auto write_chunk_size = 256UL * 1024UL;
+
+    /// NOTE: chunk buffers start on a page, so the kernel copies them out whole pages at a time.
+    inline constexpr auto write_chunk_align = 4096UL;
+
+    struct WriteChunkDeleter {
+        void operator()(unsigned char* ptr) const noexcept;
+    };
+
+    using WriteChunk = std::unique_ptr<unsigned char[], WriteChunkDeleter>;
+
+    /// NOTE: shared by a session and the writer thread, so the chunks a dropped session already queued still land and its file still gets closed.
+    struct UploadJob {
+        FileHandle file;
+        std::atomic<bool> failed;
+        std::atomic<bool> finished;  // synced and closed, or given up after a failed write
+    };
+
+    /**
+     * @brief Background thread which writes uploads behind their sessions. Chunks come from a bounded set, so queued uploads never hold more than the cap in memory.
+     */
+    class FileWriter {
+    private:
+        struct WriteTask {
+            std::shared_ptr<UploadJob> job;
+            WriteChunk chunk;  // null for the final sync and close
+            std::size_t length;
+            std::uint64_t offset;
+        };
+
+        std::deque<WriteTask> m_tasks;
+        std::vector<WriteChunk> m_free_chunks;
+        std::mutex m_mutex;
+        std::condition_variable_any m_wakeup;
+        std::size_t m_chunk_limit;
+        std::size_t m_chunks_made;
+        std::jthread m_thread;  // last, so it starts after and stops before the members it uses
+
+        void runWriter(std::stop_token stop_token);
+        void runTask(WriteTask& task) noexcept;
+
+    public:
+        explicit FileWriter(std::size_t capacity);
+
+        FileWriter(const FileWriter& other) = delete;
+        FileWriter& operator=(const FileWriter& other) = delete;
+
+        /// NOTE: gives null once the cap is reached and every chunk is staged or queued.
+        [[nodiscard]] WriteChunk tryAcquireChunk() noexcept;
+        void recycle(WriteChunk chunk) noexcept;
+
+        void submit(const std::shared_ptr<UploadJob>& job, WriteChunk chunk, std::size_t length, std::uint64_t offset);
+        void submitFinish(const std::shared_ptr<UploadJob>& job);
+    };
+
+    /**
+     * @brief Session side of one upload. Blocks get staged into a chunk, which goes to the writer once full. While the writer's queue is full, blocks get written inline instead, so a disk slower than the network throttles uploads rather than growing memory.
+     */
+    class UploadStream {
+    private:
+        FileWriter& m_writer;
+        std::shared_ptr<UploadJob> m_job;
+        WriteChunk m_chunk;
+        std::uint64_t m_chunk_offset;  // file offset of the staged chunk's first octet
+        std::size_t m_chunk_fill;
+        std::size_t m_chunk_room;      // octets the staged chunk takes before the next aligned offset
+        std::uint64_t m_offset;        // file offset of the next octet
+
+        void flushChunk();
+
+    public:
+        UploadStream(FileWriter& writer, FileHandle file);
+        ~UploadStream();
+
+        UploadStream(const UploadStream& other) = delete;
+        UploadStream& operator=(const UploadStream& other) = delete;
+
+        /// NOTE: gives false when this or an earlier write failed.
+        [[nodiscard]] bool append(const unsigned char* source, std::size_t length);
+
+        /// NOTE: queues the staged rest, then a sync and close of the file.
+        void finish();
+
+        [[nodiscard]] bool isFinished() const noexcept;
+        [[nodiscard]] bool hasFailed() const noexcept;
+    };
+}
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <array>
+#include <concepts>
 #include <string_view>
 #include "meta/helpers.hpp"
 
@@ -66,10 +67,10 @@ namespace TftpServer::MyBSock {
         std::size_t m_length;
 
     public:
+        using value_type = T;
+
         constexpr FixedBuffer() noexcept
-        : m_data {}, m_length {0UL} {
-            reset();
-        }
+        : m_data {}, m_length {0UL} {}
 
         [[nodiscard]] T* getPtr() & noexcept {
             return m_data.data();
@@ -113,8 +114,8 @@ namespace TftpServer::MyBSock {
             return true;
         }
 
+        /// NOTE: only forgets the contents, as every reader stays within `getLength()`. Zero-filling all N octets per packet cost more than the I/O itself for large buffers.
         constexpr void reset() noexcept {
-            std::fill(m_data.begin(), m_data.end(), T {});
             m_length = 0UL;
         }
 
@@ -126,4 +127,70 @@ namespace TftpServer::MyBSock {
             return { buffer.getPtr() + begin, length };
         }
     };
-}
\ No newline at end of file
+
+    /**
+     * @brief Buffer over octets owned elsewhere, e.g. one packet slot of a larger block. Its capacity is picked at runtime, unlike `FixedBuffer`.
+     */
+    template <Meta::OctetKind T>
+    class SpanBuffer {
+    private:
+        T* m_ptr;
+        std::size_t m_size;
+        std::size_t m_length;
+
+    public:
+        using value_type = T;
+
+        constexpr SpanBuffer() noexcept
+        : m_ptr {nullptr}, m_size {0UL}, m_length {0UL} {}
+
+        constexpr SpanBuffer(T* ptr, std::size_t size) noexcept
+        : m_ptr {ptr}, m_size {size}, m_length {0UL} {}
+
+        [[nodiscard]] T* getPtr() noexcept {
+            return m_ptr;
+        }
+
+        [[nodiscard]] const T* getPtr() const noexcept {
+            return m_ptr;
+        }
+
+        [[nodiscard]] constexpr std::size_t getLength() const noexcept {
+            return m_length;
+        }
+
+        void markLength(std::size_t length) noexcept {
+            m_length = length;
+        }
+
+        [[nodiscard]] constexpr std::size_t getSize() const noexcept {
+            return m_size;
+        }
+
+        [[nodiscard]] constexpr bool isEmpty() const noexcept {
+            return m_length == 0UL;
+        }
+
+        [[nodiscard]] constexpr bool isFull() const noexcept {
+            return m_length >= m_size;
+        }
+
+        /// NOTE: only forgets the contents, as every reader stays within `getLength()`.
+        constexpr void reset() noexcept {
+            m_length = 0UL;
+        }
+    };
+
+    /// NOTE: what the codec and sockets need from a buffer, so fixed and runtime-sized buffers both work with them.
+    template <typename B>
+    concept OctetBuffer = Meta::OctetKind<typename B::value_type> and requires (B& buffer, const B& const_buffer, std::size_t length) {
+        { buffer.getPtr() } -> std::same_as<typename B::value_type*>;
+        { const_buffer.getPtr() } -> std::same_as<const typename B::value_type*>;
+        { const_buffer.getLength() } -> std::same_as<std::size_t>;
+        { const_buffer.getSize() } -> std::same_as<std::size_t>;
+        { const_buffer.isEmpty() } -> std::same_as<bool>;
+        { const_buffer.isFull() } -> std::same_as<bool>;
+        buffer.markLength(length);
+        buffer.reset();
+    };
+}
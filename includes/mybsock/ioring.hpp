@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+
+namespace TftpServer::MyBSock {
+    struct IoCompletion {
+        std::uint64_t tag;  // the tag given when queueing the operation
+        int result;         // byte count, or a negated errno
+    };
+
+    /**
+     * @brief One io_uring submission / completion ring over the raw syscalls, owned by a single thread. File reads and datagram sends get queued, then all of them go to the kernel with one `io_uring_enter`.
+     */
+    class IoRing {
+    private:
+        std::vector<unsigned int> m_free_buffers;  // unused indices of the registered buffer table
+        io_uring_sqe* m_sqes;
+        io_uring_cqe* m_cqes;
+        unsigned int* m_sq_head;
+        unsigned int* m_sq_tail;
+        unsigned int* m_sq_array;
+        unsigned int* m_cq_head;
+        unsigned int* m_cq_tail;
+        void* m_sq_ring_ptr;
+        void* m_cq_ring_ptr;
+        std::size_t m_sq_ring_size;
+        std::size_t m_cq_ring_size;
+        std::size_t m_sqes_size;
+        unsigned int m_sq_mask;
+        unsigned int m_cq_mask;
+        unsigned int m_sq_entries;
+        unsigned int m_queued;  // SQEs written since the last submit
+        int m_fd;
+
+        [[nodiscard]] unsigned int getFreeEntries() const noexcept;
+        [[nodiscard]] io_uring_sqe* nextEntry() noexcept;
+        void fillRead(io_uring_sqe* entry, int fd, void* target, unsigned int length, std::uint64_t offset, std::optional<unsigned int> buffer_index, std::uint64_t tag) noexcept;
+        void fillSend(io_uring_sqe* entry, int fd, const msghdr* message, std::uint64_t tag) noexcept;
+        void closeRing() noexcept;
+
+    public:
+        IoRing(unsigned int entries, unsigned int buffer_slots);
+        ~IoRing();
+
+        IoRing(const IoRing& other) = delete;
+        IoRing& operator=(const IoRing& other) = delete;
+
+        /// NOTE: pins the buffer once, so fixed reads into it skip the per-call page mapping. Gives nothing when the table is full or the kernel refuses.
+        [[nodiscard]] std::optional<unsigned int> registerBuffer(void* ptr, std::size_t length) noexcept;
+        void unregisterBuffer(unsigned int buffer_index) noexcept;
+
+        /// NOTE: for messages whose octets are ready by the time of the next submit, so the send need not wait on anything.
+        [[nodiscard]] bool queueSend(int fd, const msghdr* message, std::uint64_t tag) noexcept;
+
+        /// NOTE: `buffer_index` must be a registered buffer containing `target`, or empty for a plain read. Links the send to the read, so it starts once the read completed and gets cancelled if the read fails. Pairs run independently of each other, so one block's disk read overlaps the sends of the others. Queues both or neither.
+        [[nodiscard]] bool queueReadSend(int file_fd, void* target, unsigned int length, std::uint64_t offset, std::optional<unsigned int> buffer_index, std::uint64_t read_tag, int socket_fd, const msghdr* message, std::uint64_t send_tag) noexcept;
+
+        /// NOTE: submits all queued operations and waits until each of them completed. Gives the number submitted.
+        [[nodiscard]] std::size_t submitAndWait() noexcept;
+
+        [[nodiscard]] bool popCompletion(IoCompletion& completion) noexcept;
+    };
+}
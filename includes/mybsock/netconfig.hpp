@@ -1,13 +1,16 @@
 #pragma once
 
+#include <cstddef>
 #include <optional>
 #include <netdb.h>
+#include <netinet/in.h>
 
 namespace TftpServer::MyBSock {
     class SocketGenerator {
     public:
         SocketGenerator() = delete;
-        SocketGenerator(const char* port_cstr);
+        /// NOTE: with `reuse_port`, several sockets may bind the same port and the kernel spreads incoming peers across them.
+        SocketGenerator(const char* port_cstr, bool reuse_port = false);
         ~SocketGenerator();
 
         explicit operator bool() const noexcept;
@@ -18,5 +21,15 @@ namespace TftpServer::MyBSock {
 
         addrinfo* m_head;
         addrinfo* m_cursor;
+        bool m_reuse_port;
     };
+
+    /// NOTE: asks the kernel for the route MTU towards a peer, which bounds how large a datagram may be before IP fragments it.
+    [[nodiscard]] std::optional<std::size_t> queryPathMtu(const sockaddr_in& peer);
+
+    /// NOTE: lets a socket send to multicast groups through the interface holding `interface_ip`, or the routing table's pick for INADDR_ANY. Local members still get the datagrams.
+    [[nodiscard]] bool enableMulticastSend(int socket_fd, in_addr_t interface_ip);
+
+    /// NOTE: grows the socket's send buffer to hold at least `bytes` of queued datagrams, as far as `net.core.wmem_max` allows. It never shrinks the buffer.
+    [[nodiscard]] bool reserveSendBuffer(int socket_fd, std::size_t bytes);
 }
\ No newline at end of file
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace TftpServer::MyBSock {
+    inline constexpr auto cache_line_size = 64UL;
+
+    [[nodiscard]] constexpr std::size_t roundToCacheLine(std::size_t length) noexcept {
+        return (length + cache_line_size - 1UL) / cache_line_size * cache_line_size;
+    }
+
+    /// NOTE: one contiguous run of pooled memory, handed back to its pool as a whole.
+    struct PacketRun {
+        unsigned char* ptr;
+        std::size_t size;
+        std::size_t size_class;
+    };
+
+    struct PacketPoolStats {
+        std::size_t reserved_bytes;  // mapped from the kernel so far, which never exceeds the limit
+        std::size_t used_bytes;      // handed out in runs right now
+        std::size_t huge_regions;    // regions backed by explicit huge pages
+        std::size_t failed_acquires;
+    };
+
+    /**
+     * @brief Per-thread pool of page-aligned runs for packet buffers, in power-of-two size classes. Freed runs go back on their class's free list, so steady traffic stops mapping memory altogether.
+     */
+    class PacketPool {
+    public:
+        static constexpr auto min_run_size = 4096UL;
+        static constexpr auto class_count = 11UL;  // 4KiB to 4MiB
+        static constexpr auto region_size = 2UL * 1024UL * 1024UL;
+
+    private:
+        std::array<std::vector<unsigned char*>, class_count> m_free_runs;
+        std::array<std::size_t, class_count> m_class_runs;  // runs carved per class, free or not
+        std::vector<std::pair<void*, std::size_t>> m_regions;
+        PacketPoolStats m_stats;
+        std::size_t m_limit;
+        bool m_huge_pages;
+
+        [[nodiscard]] bool growClass(std::size_t size_class) noexcept;
+
+    public:
+        /// NOTE: with `huge_pages`, regions first try explicit 2MiB pages and fall back to transparent ones when none are reserved.
+        PacketPool(std::size_t limit, bool huge_pages) noexcept;
+        ~PacketPool();
+
+        PacketPool(const PacketPool& other) = delete;
+        PacketPool& operator=(const PacketPool& other) = delete;
+
+        /// NOTE: the run holds at least `length` octets. Gives nothing once the pool would pass its limit.
+        [[nodiscard]] std::optional<PacketRun> acquire(std::size_t length) noexcept;
+        void release(const PacketRun& run) noexcept;
+
+        [[nodiscard]] const PacketPoolStats& getStats() const noexcept;
+
+        [[nodiscard]] static std::size_t getRunSize(std::size_t length) noexcept;
+    };
+
+    /**
+     * @brief Per-thread slab of cache-line aligned cells for objects of one type. Cells come in pages and get recycled, so creating an object mostly pops a free list instead of calling `new`.
+     */
+    template <typename T>
+    class ObjectSlab {
+    public:
+        static constexpr auto cell_align = std::max(alignof(T), cache_line_size);
+        static constexpr auto cell_size = (sizeof(T) + cell_align - 1UL) / cell_align * cell_align;
+
+        struct Deleter {
+            ObjectSlab* slab;
+
+            void operator()(T* ptr) const noexcept {
+                ptr->~T();
+                slab->m_free_cells.push_back(ptr);
+            }
+        };
+
+        using Handle = std::unique_ptr<T, Deleter>;
+
+    private:
+        struct PageDeleter {
+            void operator()(std::byte* page) const noexcept {
+                ::operator delete[](page, std::align_val_t {cell_align});
+            }
+        };
+
+        std::vector<std::unique_ptr<std::byte[], PageDeleter>> m_pages;
+        std::vector<void*> m_free_cells;
+        std::size_t m_cells_per_page;
+
+        void growPage() {
+            std::unique_ptr<std::byte[], PageDeleter> page {static_cast<std::byte*>(::operator new[](cell_size * m_cells_per_page, std::align_val_t {cell_align}))};
+
+            /// NOTE: the free list gets room for every cell up front, so giving a cell back never allocates.
+            m_free_cells.reserve((m_pages.size() + 1UL) * m_cells_per_page);
+
+            for (auto cell_index = m_cells_per_page; cell_index > 0UL; cell_index--) {
+                m_free_cells.push_back(page.get() + (cell_index - 1UL) * cell_size);
+            }
+
+            m_pages.push_back(std::move(page));
+        }
+
+    public:
+        explicit ObjectSlab(std::size_t cells_per_page)
+        : m_pages {}, m_free_cells {}, m_cells_per_page {std::max(cells_per_page, 1UL)} {}
+
+        ObjectSlab(const ObjectSlab& other) = delete;
+        ObjectSlab& operator=(const ObjectSlab& other) = delete;
+
+        template <typename... Args>
+        [[nodiscard]] Handle make(Args&&... args) {
+            if (m_free_cells.empty()) {
+                growPage();
+            }
+
+            auto* cell = m_free_cells.back();
+            auto* object = ::new (cell) T(std::forward<Args>(args)...);
+
+            m_free_cells.pop_back();
+
+            return Handle {object, Deleter {this}};
+        }
+
+        [[nodiscard]] std::size_t getCapacity() const noexcept {
+            return m_pages.size() * m_cells_per_page;
+        }
+
+        [[nodiscard]] std::size_t getLive() const noexcept {
+            return getCapacity() - m_free_cells.size();
+        }
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+
+namespace TftpServer::MyBSock {
+    enum class EventKind {
+        readable,
+        writable,
+        tick,
+        stop
+    };
+
+    struct ReactorEvent {
+        void* context;        // the pointer given to `watch` for readable and writable events
+        std::uint64_t count;  // elapsed periods for tick events
+        EventKind kind;
+    };
+
+    /**
+     * @brief Multiplexes watched descriptors, a periodic tick timer, and a stop eventfd over one epoll instance. The tick is disarmed by default so an idle loop sleeps in the kernel.
+     */
+    class Reactor {
+    private:
+        int m_epoll_fd;
+        int m_stop_fd;
+        int m_timer_fd;
+
+        void closeDescriptors() noexcept;
+
+    public:
+        Reactor();
+        ~Reactor();
+
+        Reactor(const Reactor& other) = delete;
+        Reactor& operator=(const Reactor& other) = delete;
+
+        [[nodiscard]] bool isUsable() const noexcept;
+
+        [[nodiscard]] bool watch(int fd, void* context) noexcept;
+        void unwatch(int fd) noexcept;
+
+        /// NOTE: adds or drops interest in a watched descriptor turning writable. A descriptor both readable and writable reports readable first, and writable on the next wait.
+        [[nodiscard]] bool watchWritable(int fd, void* context, bool writable) noexcept;
+
+        /// NOTE: a zero period disarms the tick timer.
+        [[nodiscard]] bool armTicks(std::chrono::milliseconds period) noexcept;
+
+        /// NOTE: only does a `write` to the eventfd, so this is safe to call from a signal handler.
+        void requestStop() const noexcept;
+
+        [[nodiscard]] std::size_t waitEvents(std::span<ReactorEvent> events, int timeout_ms = -1);
+    };
+}
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <array>
+#include <bitset>
+#include <cerrno>
+#include <span>
 #include <unistd.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include "mybsock/buffers.hpp"
 
@@ -11,6 +16,7 @@ namespace TftpServer::MyBSock {
     enum class IOStatus {
         ok,
         invalid_args,
+        would_block,
         pipe_closed
     };
 
@@ -19,6 +25,129 @@ namespace TftpServer::MyBSock {
         IOStatus status;
     };
 
+    /**
+     * @brief Fixed set of datagram slots handed to the kernel in one `recvmmsg` or `sendmmsg` call. Each slot points at buffer storage owned by the caller, which must outlive the batch.
+     */
+    template <std::size_t N> requires (N > 0UL)
+    class DatagramBatch {
+    private:
+        std::array<mmsghdr, N> m_headers;
+        std::array<iovec, N> m_vectors;
+        std::array<sockaddr_in, N> m_addresses;
+        std::size_t m_count;   // slots in use: bound receive buffers, or queued sends
+        std::size_t m_filled;  // datagrams the last receive stored
+        std::size_t m_sent;    // queued sends which already went out while the rest waits for room
+
+        friend class UDPServerSocket;
+
+        [[nodiscard]] bool pushSlot(void* ptr, std::size_t n, const sockaddr_in& address) noexcept {
+            if (m_count >= N) {
+                return false;
+            }
+
+            m_vectors[m_count] = { ptr, n };
+            m_addresses[m_count] = address;
+            m_headers[m_count].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            m_headers[m_count].msg_len = 0U;
+            m_count++;
+
+            return true;
+        }
+
+    public:
+        DatagramBatch() noexcept
+        : m_headers {}, m_vectors {}, m_addresses {}, m_count {0UL}, m_filled {0UL}, m_sent {0UL} {
+            for (auto slot = 0UL; slot < N; slot++) {
+                m_headers[slot].msg_hdr.msg_name = &m_addresses[slot];
+                m_headers[slot].msg_hdr.msg_iov = &m_vectors[slot];
+                m_headers[slot].msg_hdr.msg_iovlen = 1;
+            }
+        }
+
+        /// NOTE: the headers point into the batch itself, so it must stay in place.
+        DatagramBatch(const DatagramBatch& other) = delete;
+        DatagramBatch& operator=(const DatagramBatch& other) = delete;
+
+        [[nodiscard]] constexpr std::size_t getCapacity() const noexcept {
+            return N;
+        }
+
+        [[nodiscard]] std::size_t getCount() const noexcept {
+            return m_count;
+        }
+
+        [[nodiscard]] std::size_t getFilled() const noexcept {
+            return m_filled;
+        }
+
+        [[nodiscard]] std::size_t getLength(std::size_t slot) const noexcept {
+            return m_headers[slot].msg_len;
+        }
+
+        [[nodiscard]] IOResult getPeer(std::size_t slot) const noexcept {
+            return { m_addresses[slot], IOStatus::ok };
+        }
+
+        /// NOTE: queued sends a `sendBatch` call left behind because the socket buffer was full.
+        [[nodiscard]] std::size_t getUnsent() const noexcept {
+            return m_count - m_sent;
+        }
+
+        /// NOTE: for handing a queued send to another submitter such as an `IoRing`. The header stays valid until the batch gets cleared.
+        [[nodiscard]] const msghdr* getMessage(std::size_t slot) const noexcept {
+            return &m_headers[slot].msg_hdr;
+        }
+
+        /// NOTE: keeps only the queued sends whose bit is set, moved to the front in their order, so another submitter's failures go out again on the next `sendBatch` call.
+        void retainSends(const std::bitset<N>& keep) noexcept {
+            auto kept_n = 0UL;
+
+            for (auto slot = 0UL; slot < m_count; slot++) {
+                if (not keep.test(slot)) {
+                    continue;
+                }
+
+                m_vectors[kept_n] = m_vectors[slot];
+                m_addresses[kept_n] = m_addresses[slot];
+                kept_n++;
+            }
+
+            m_count = kept_n;
+            m_sent = 0UL;
+        }
+
+        void clear() noexcept {
+            m_count = 0UL;
+            m_filled = 0UL;
+            m_sent = 0UL;
+        }
+
+        /// NOTE: for receiving, a slot is bound once and refilled by every `recieveBatch` call.
+        template <OctetBuffer Buffer>
+        [[nodiscard]] bool bindReceive(Buffer& buffer) noexcept {
+            return pushSlot(buffer.getPtr(), buffer.getSize(), {});
+        }
+
+        /// NOTE: for sending, the first `n` octets of `buffer` go out to `target` on the next `sendBatch` call.
+        template <OctetBuffer Buffer>
+        [[nodiscard]] bool queueSend(const Buffer& buffer, std::size_t n, const sockaddr_in& target) noexcept {
+            if (buffer.isEmpty() or n > buffer.getLength()) {
+                return false;
+            }
+
+            return pushSlot(const_cast<typename Buffer::value_type*>(buffer.getPtr()), n, target);
+        }
+
+        /// NOTE: for sending octets no buffer of the caller wraps, such as pre-encoded packets, which must stay in place until the next `sendBatch` call.
+        [[nodiscard]] bool queueSend(std::span<const unsigned char> octets, const sockaddr_in& target) noexcept {
+            if (octets.empty()) {
+                return false;
+            }
+
+            return pushSlot(const_cast<unsigned char*>(octets.data()), octets.size(), target);
+        }
+    };
+
     class UDPServerSocket {
     private:
         int m_fd;
@@ -37,9 +166,10 @@ namespace TftpServer::MyBSock {
         UDPServerSocket& operator=(UDPServerSocket&& other) noexcept;
 
         [[nodiscard]] bool isUsable() const noexcept;
+        [[nodiscard]] int getFd() const noexcept;
 
-        template <typename BufferT, std::size_t BufferN>
-        [[nodiscard]] IOResult recieveFrom(FixedBuffer<BufferT, BufferN>& buffer, std::size_t n) {
+        template <OctetBuffer Buffer>
+        [[nodiscard]] IOResult recieveFrom(Buffer& buffer, std::size_t n) {
             if (m_closed) {
                 return { {}, IOStatus::pipe_closed };
             }
@@ -59,6 +189,8 @@ namespace TftpServer::MyBSock {
             if (count > 0) {
                 buffer.markLength(count);
                 temp.status= IOStatus::ok;
+            } else if (count < 0 and (errno == EAGAIN or errno == EWOULDBLOCK)) {
+                temp.status = IOStatus::would_block;
             } else {
                 temp.status = IOStatus::pipe_closed;
             }
@@ -66,8 +198,8 @@ namespace TftpServer::MyBSock {
             return temp;
         }
 
-        template <typename BufferT, std::size_t BufferN>
-        IOResult sendTo(const FixedBuffer<BufferT, BufferN>& buffer, std::size_t n, const IOResult& prev) {
+        template <OctetBuffer Buffer>
+        IOResult sendTo(const Buffer& buffer, std::size_t n, const IOResult& prev) {
             if (m_closed) {
                 return { {}, IOStatus::pipe_closed };
             }
@@ -90,5 +222,59 @@ namespace TftpServer::MyBSock {
 
             return temp;
         }
+    
+        /// NOTE: fills the bound slots of `batch` with as many queued datagrams as are ready, all in one syscall. It never blocks.
+        template <std::size_t N>
+        [[nodiscard]] IOStatus recieveBatch(DatagramBatch<N>& batch) {
+            batch.m_filled = 0UL;
+
+            if (m_closed) {
+                return IOStatus::pipe_closed;
+            }
+
+            if (batch.m_count == 0UL) {
+                return IOStatus::invalid_args;
+            }
+
+            for (auto slot = 0UL; slot < batch.m_count; slot++) {
+                batch.m_headers[slot].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+                batch.m_headers[slot].msg_len = 0U;
+            }
+
+            const auto count = recvmmsg(m_fd, batch.m_headers.data(), static_cast<unsigned int>(batch.m_count), MSG_DONTWAIT, nullptr);
+
+            if (count > 0) {
+                batch.m_filled = static_cast<std::size_t>(count);
+                return IOStatus::ok;
+            } else if (count < 0 and (errno == EAGAIN or errno == EWOULDBLOCK)) {
+                return IOStatus::would_block;
+            }
+
+            return IOStatus::pipe_closed;
+        }
+
+        /// NOTE: sends the queued datagrams of `batch`, then empties it. When the socket buffer fills up, it gives `would_block` and keeps the unsent rest queued, so a later call once the socket is writable carries on from there.
+        template <std::size_t N>
+        IOStatus sendBatch(DatagramBatch<N>& batch) {
+            auto status = (m_closed) ? IOStatus::pipe_closed : IOStatus::ok;
+
+            while (status == IOStatus::ok and batch.m_sent < batch.m_count) {
+                const auto count = sendmmsg(m_fd, batch.m_headers.data() + batch.m_sent, static_cast<unsigned int>(batch.m_count - batch.m_sent), 0);
+
+                if (count > 0) {
+                    batch.m_sent += static_cast<std::size_t>(count);
+                } else if (count < 0 and errno == EINTR) {
+                    continue;
+                } else if (count < 0 and (errno == EAGAIN or errno == EWOULDBLOCK)) {
+                    return IOStatus::would_block;
+                } else {
+                    status = IOStatus::pipe_closed;
+                }
+            }
+
+            batch.clear();
+
+            return status;
+        }
     };
 }
\ No newline at end of file
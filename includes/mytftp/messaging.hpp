@@ -1,8 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <utility>
+#include <cctype>
 #include <cstring>
+#include <limits>
 #include <string>
+#include <string_view>
+#include <arpa/inet.h>
 #include "meta/helpers.hpp"
 #include "mybsock/buffers.hpp"
 #include "mytftp/types.hpp"
@@ -15,11 +20,19 @@ namespace TftpServer::MyTftp {
     struct DataOpt {};
     struct AckOpt {};
     struct ErrOpt {};
-
-    /// NOTE: denotes max payload length of `RRQ/WRQ`, assuming 512B for each filename and mode string.
-    inline constexpr auto max_data_chunk_size = 512UL;
+    struct OAckOpt {};
+
+    /// NOTE: RFC 1350 block size, used whenever no `blksize` option was negotiated.
+    inline constexpr auto default_block_size = 512UL;
+    /// NOTE: RFC 2348 bounds for the `blksize` option.
+    inline constexpr auto min_block_size = 8UL;
+    inline constexpr auto max_block_size = 65464UL;
+    /// NOTE: a DATA message is its 2B opcode and 2B block number followed by up to one block.
+    inline constexpr auto data_header_size = 4UL;
+    inline constexpr auto max_packet_size = data_header_size + max_block_size;
     inline constexpr auto max_payload_size = 514UL;
-    inline constexpr auto dud_payload_num = 1024UL;
+    /// NOTE: must lie past any real offset, as negotiated blocks make messages far longer than 1KiB.
+    inline constexpr auto dud_payload_num = std::numeric_limits<std::size_t>::max();
 
     inline const std::string mode_name_netascii = "netascii";
     inline const std::string mode_name_mail = "mail";
@@ -35,14 +48,33 @@ namespace TftpServer::MyTftp {
         }
     }
 
+    /// NOTE: RFC 1350 allows any mix of cases in the mode, so "NetASCII" names netascii too. Unknown modes give `DataMode::dud`.
+    [[nodiscard]] inline DataMode toFileMode(std::string_view name) noexcept {
+        const auto matches = [name](const std::string& mode_name) noexcept {
+            return std::ranges::equal(name, mode_name, [](unsigned char lhs, unsigned char rhs) {
+                return std::tolower(lhs) == rhs;
+            });
+        };
+
+        if (matches(mode_name_netascii)) {
+            return DataMode::netascii;
+        } else if (matches(mode_name_octet)) {
+            return DataMode::octet;
+        } else if (matches(mode_name_mail)) {
+            return DataMode::mail;
+        } else {
+            return DataMode::dud;
+        }
+    }
+
     template <typename DataType>
     struct HelperResult {
         DataType data;
         std::size_t current_pos;
     };
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] HelperResult<tftp_u16> readU16(const MyBSock::FixedBuffer<T, N>& source, std::size_t begin) {
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] HelperResult<tftp_u16> readU16(const Buffer& source, std::size_t begin) {
         tftp_u16 temp = 0;
 
         if (begin + 2UL > source.getLength()) {
@@ -57,8 +89,8 @@ namespace TftpServer::MyTftp {
         return {temp, begin + 2UL};
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] HelperResult<std::string> readText(const MyBSock::FixedBuffer<T, N>& source, std::size_t begin) {
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] HelperResult<std::string> readText(const Buffer& source, std::size_t begin) {
         std::string temp;
         const auto source_len = source.getLength();
 
@@ -66,18 +98,11 @@ namespace TftpServer::MyTftp {
             return {temp, dud_payload_num};
         }
 
-        const auto* read_ptr = source.getPtr();
-        auto read_offset = begin;
-
-        for (; read_offset < source_len; read_offset++) {
-            const auto c = static_cast<char>(read_ptr[read_offset]);
-
-            if (c == '\0') {
-                break;
-            }
+        const auto* read_ptr = source.getPtr() + begin;
+        const auto* nul_ptr = static_cast<const typename Buffer::value_type*>(std::memchr(read_ptr, '\0', source_len - begin));
+        const auto read_offset = (nul_ptr != nullptr) ? static_cast<std::size_t>(nul_ptr - source.getPtr()) : source_len;
 
-            temp += c;
-        }
+        temp.assign(reinterpret_cast<const char*>(read_ptr), read_offset - begin);
 
         /// NOTE: +1 to the offset since 0 is a delimiter for TFTP strings within payloads, so I must skip it for the next data field.
         return {
@@ -86,24 +111,20 @@ namespace TftpServer::MyTftp {
         };
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] HelperResult<std::u8string> readBlob(const MyBSock::FixedBuffer<T, N>& source, std::size_t begin, std::size_t blob_length) {
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] HelperResult<std::u8string> readBlob(const Buffer& source, std::size_t begin, std::size_t blob_length) {
         std::u8string temp;
         const auto source_len = source.getLength();
 
-        if (begin >= source_len) {
+        /// NOTE: an empty blob at the very end is valid, e.g. the final DATA block of a file whose size is a multiple of the block size.
+        if (begin > source_len) {
             return {temp, dud_payload_num};
         }
 
-        const auto* read_ptr = source.getPtr();
-        auto read_offset = begin;
-        auto pending_rc = blob_length;
+        const auto read_n = std::min(blob_length, source_len - begin);
+        const auto read_offset = begin + read_n;
 
-        while (pending_rc > 0 and read_offset < source_len) {
-            temp += static_cast<tftp_u8>(read_ptr[read_offset]);
-            pending_rc--;
-            read_offset++;
-        }
+        temp.assign(reinterpret_cast<const char8_t*>(source.getPtr() + begin), read_n);
 
         return {
             std::move(temp),
@@ -111,22 +132,22 @@ namespace TftpServer::MyTftp {
         };
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] HelperResult<bool> writeU16(MyBSock::FixedBuffer<T, N>& target, std::size_t begin, tftp_u16 value) {
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] HelperResult<bool> writeU16(Buffer& target, std::size_t begin, tftp_u16 value) {
         const auto network_ord_value = htons(value);
 
         if (begin + 2UL > target.getSize()) {
             return { false, dud_payload_num };
         }
 
-        auto* write_ptr = target.getPtr();
+        auto* write_ptr = target.getPtr() + begin;
         std::memcpy(write_ptr, &network_ord_value, 2UL);
 
         return { true, begin + 2UL };
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] HelperResult<bool> writeText(MyBSock::FixedBuffer<T, N>& target, std::size_t begin, const std::string& value) {
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] HelperResult<bool> writeText(Buffer& target, std::size_t begin, const std::string& value) {
         const auto value_len = value.size();
         const auto target_size = target.getSize();
 
@@ -134,79 +155,113 @@ namespace TftpServer::MyTftp {
             return { false, dud_payload_num };
         }
 
-        const auto* value_read_ptr = value.c_str();
         auto* write_ptr = target.getPtr();
-        auto write_offset = begin;
-        auto pending_n = value_len;
+        const auto write_offset = begin + value_len;
 
-        while (pending_n > 0 and write_offset < target_size) {
-            write_ptr[write_offset] = static_cast<T>(*value_read_ptr);
-            pending_n--;
-            write_offset++;
-            value_read_ptr++;
-        }
+        std::memcpy(write_ptr + begin, value.data(), value_len);
 
-        return { true, write_offset };
+        /// NOTE: TFTP strings are NUL-terminated on the wire, so the terminator must be written out too.
+        write_ptr[write_offset] = typename Buffer::value_type {};
+
+        return { true, write_offset + 1UL };
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] HelperResult<bool> writeBlob(MyBSock::FixedBuffer<T, N>& target, std::size_t begin, const std::u8string& value) {
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] HelperResult<bool> writeBlob(Buffer& target, std::size_t begin, const std::u8string& value) {
         const auto value_len = value.size();
         const auto target_size = target.getSize();
 
-        if (begin + value_len >= target_size) {
+        if (begin + value_len > target_size) {
             return { false, dud_payload_num };
         }
 
-        const auto* value_read_ptr = value.c_str();
-        auto* write_ptr = target.getPtr();
+        std::memcpy(target.getPtr() + begin, value.data(), value_len);
+
+        return { true, begin + value_len };
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] HelperResult<OptionList> readOptions(const Buffer& source, std::size_t begin) {
+        OptionList temp;
+        const auto source_len = source.getLength();
+        auto read_offset = begin;
+
+        while (read_offset < source_len) {
+            auto [name, pos_1] = readText(source, read_offset);
+            auto [value, pos_2] = readText(source, pos_1);
+
+            /// NOTE: each option needs both NUL-terminated strings, so a dangling name means the message is malformed.
+            if (pos_1 > source_len or pos_2 > source_len or name.empty()) {
+                return {{}, dud_payload_num};
+            }
+
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+                return static_cast<char>(std::tolower(c));
+            });
+
+            temp.push_back({std::move(name), std::move(value)});
+            read_offset = pos_2;
+        }
+
+        return {std::move(temp), read_offset};
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] HelperResult<bool> writeOptions(Buffer& target, std::size_t begin, const OptionList& options) {
         auto write_offset = begin;
-        auto pending_n = value_len;
 
-        while (pending_n > 0 and write_offset < target_size) {
-            write_ptr[write_offset] = static_cast<T>(*value_read_ptr);
-            pending_n--;
-            write_offset++;
-            value_read_ptr++;
+        for (const auto& [name, value] : options) {
+            auto [name_ok, pos_1] = writeText(target, write_offset, name);
+
+            if (not name_ok) {
+                return { false, dud_payload_num };
+            }
+
+            auto [value_ok, pos_2] = writeText(target, pos_1, value);
+
+            if (not value_ok) {
+                return { false, dud_payload_num };
+            }
+
+            write_offset = pos_2;
         }
 
         return { true, write_offset };
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] RWPayload parsePayload(const MyBSock::FixedBuffer<T, N>& source, [[maybe_unused]] RWOpt opt) {
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] RWPayload parsePayload(const Buffer& source, [[maybe_unused]] RWOpt opt) {
         auto parse_pos = 2UL;
 
         auto [filename, pos_1] = readText(source, parse_pos);
 
         if (pos_1 == dud_payload_num) {
-            return { "", DataMode::dud };
+            return { "", DataMode::dud, {} };
         }
 
         auto [filemode, pos_2] = readText(source, pos_1);
 
         if (pos_2 == dud_payload_num) {
-            return { "", DataMode::dud };
+            return { "", DataMode::dud, {} };
         }
 
-        DataMode temp_mode;
+        const auto temp_mode = toFileMode(filemode);
 
-        if (filemode == "netascii") {
-            temp_mode = DataMode::netascii;
-        } else if (filemode == "mail") {
-            temp_mode = DataMode::mail;
-        } else {
-            temp_mode = DataMode::octet;
+        auto [options, pos_3] = readOptions(source, pos_2);
+
+        if (pos_3 == dud_payload_num) {
+            return { "", DataMode::dud, {} };
         }
 
         return {
             std::move(filename),
-            temp_mode
+            temp_mode,
+            std::move(options)
         };
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] DataPayload parsePayload(const MyBSock::FixedBuffer<T, N>& source, [[maybe_unused]] DataOpt opt) {
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] DataPayload parsePayload(const Buffer& source, [[maybe_unused]] DataOpt opt) {
         auto parse_pos = 2UL;
 
         auto [block_n, pos_1] = readU16(source, parse_pos);
@@ -215,7 +270,7 @@ namespace TftpServer::MyTftp {
             return { 0, {} };
         }
 
-        auto [data_blob, pos_2] = readBlob(source, pos_1, max_data_chunk_size);
+        auto [data_blob, pos_2] = readBlob(source, pos_1, source.getLength() - pos_1);
 
         if (pos_2 == dud_payload_num) {
             return { 0, {}};
@@ -224,8 +279,8 @@ namespace TftpServer::MyTftp {
         return { block_n, std::move(data_blob) };
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] AckPayload parsePayload(const MyBSock::FixedBuffer<T, N>& source, [[maybe_unused]] AckOpt opt) {
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] AckPayload parsePayload(const Buffer& source, [[maybe_unused]] AckOpt opt) {
         auto parse_pos = 2UL;
 
         auto [block_n, pos_1] = readU16(source, parse_pos);
@@ -237,8 +292,8 @@ namespace TftpServer::MyTftp {
         return { block_n };
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] ErrorPayload parsePayload(const MyBSock::FixedBuffer<T, N>& source, [[maybe_unused]] ErrOpt opt) {
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] ErrorPayload parsePayload(const Buffer& source, [[maybe_unused]] ErrOpt opt) {
         auto parse_pos = 2UL;
 
         auto [raw_errcode, pos_1] = readU16(source, parse_pos);
@@ -259,8 +314,21 @@ namespace TftpServer::MyTftp {
         };
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] Message parseMessage(const MyBSock::FixedBuffer<T, N>& source) {
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] OAckPayload parsePayload(const Buffer& source, [[maybe_unused]] OAckOpt opt) {
+        auto parse_pos = 2UL;
+
+        auto [options, pos_1] = readOptions(source, parse_pos);
+
+        if (pos_1 == dud_payload_num) {
+            return {};
+        }
+
+        return { std::move(options) };
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] Message parseMessage(const Buffer& source) {
         auto parse_pos = 0UL;
 
         const auto [opcode, pos] = readU16(source, parse_pos);
@@ -279,14 +347,16 @@ namespace TftpServer::MyTftp {
             return { opcode_enum_v, parsePayload(source, AckOpt {}) };
         } else if (opcode_enum_v == Opcode::err) {
             return { opcode_enum_v, parsePayload(source, ErrOpt {}) };
+        } else if (opcode_enum_v == Opcode::oack) {
+            return { opcode_enum_v, parsePayload(source, OAckOpt {}) };
         }
 
         return { Opcode::none, DudPayload {} };
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] bool serializePayload(MyBSock::FixedBuffer<T, N>& target, const RWPayload& payload) {
-        auto [filename, filemode] = payload;
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializePayload(Buffer& target, const RWPayload& payload) {
+        const auto& [filename, filemode, options] = payload;
         
         auto [field_1_ok, pos_1] = writeText(target, 2UL, filename);
 
@@ -302,13 +372,20 @@ namespace TftpServer::MyTftp {
             return false;
         }
 
-        target.markLength(pos_2);
+        auto [field_3_ok, pos_3] = writeOptions(target, pos_2, options);
+
+        if (not field_3_ok) {
+            target.markLength(0);
+            return false;
+        }
+
+        target.markLength(pos_3);
         return true;
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] bool serializePayload(MyBSock::FixedBuffer<T, N>& target, const DataPayload& payload) {
-        auto [block_n, data_blob] = payload;
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializePayload(Buffer& target, const DataPayload& payload) {
+        const auto& [block_n, data_blob] = payload;
 
         auto [field_1_ok, pos_1] = writeU16(target, 2UL, block_n);
 
@@ -328,8 +405,23 @@ namespace TftpServer::MyTftp {
         return true;
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] bool serializePayload(MyBSock::FixedBuffer<T, N>& target, const AckPayload& payload) {
+    /// NOTE: writes only the opcode and block number of a DATA message, so the caller can read file contents right after them without an intermediate copy.
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializeDataHeader(Buffer& target, tftp_u16 block_n) {
+        auto [field_0_ok, pos_0] = writeU16(target, 0UL, static_cast<tftp_u16>(Opcode::data));
+        auto [field_1_ok, pos_1] = writeU16(target, pos_0, block_n);
+
+        if (not field_0_ok or not field_1_ok) {
+            target.markLength(0);
+            return false;
+        }
+
+        target.markLength(pos_1);
+        return true;
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializePayload(Buffer& target, const AckPayload& payload) {
         auto [block_n] = payload;
 
         auto [field_1_ok, pos_1] = writeU16(target, 2UL, block_n);
@@ -343,9 +435,9 @@ namespace TftpServer::MyTftp {
         return true;
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] bool serializePayload(MyBSock::FixedBuffer<T, N>& target, const ErrorPayload& payload) {
-        auto [errcode, msg] = payload;
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializePayload(Buffer& target, const ErrorPayload& payload) {
+        const auto& [errcode, msg] = payload;
         const auto errcode_n = static_cast<tftp_u16>(errcode);
 
         auto [field_1_ok, pos_1] = writeU16(target, 2UL, errcode_n);
@@ -366,8 +458,21 @@ namespace TftpServer::MyTftp {
         return true;
     }
 
-    template <Meta::OctetKind T, std::size_t N>
-    [[nodiscard]] bool serializeMessage(MyBSock::FixedBuffer<T, N>& target, const Message& msg) {
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializePayload(Buffer& target, const OAckPayload& payload) {
+        auto [field_1_ok, pos_1] = writeOptions(target, 2UL, payload.options);
+
+        if (not field_1_ok) {
+            target.markLength(0);
+            return false;
+        }
+
+        target.markLength(pos_1);
+        return true;
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializeMessage(Buffer& target, const Message& msg) {
         const auto msg_opcode = msg.op;
         const auto opcode_n = static_cast<tftp_u16>(msg_opcode);
 
@@ -386,6 +491,8 @@ namespace TftpServer::MyTftp {
             return serializePayload(target, std::get<AckPayload>(msg.payload));
         } else if (msg_opcode == Opcode::err) {
             return serializePayload(target, std::get<ErrorPayload>(msg.payload));
+        } else if (msg_opcode == Opcode::oack) {
+            return serializePayload(target, std::get<OAckPayload>(msg.payload));
         }
 
         return false;
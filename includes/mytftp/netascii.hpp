@@ -0,0 +1,220 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#if defined(__SSE2__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include "mytftp/messaging.hpp"
+#include "mytftp/views.hpp"
+
+namespace TftpServer::MyTftp {
+    inline constexpr tftp_u8 ascii_lf = '\n';
+    inline constexpr tftp_u8 ascii_cr = '\r';
+    inline constexpr tftp_u8 ascii_nul = '\0';
+
+    /// NOTE: RFC 764 pairs (CR LF, CR NUL) may straddle a block boundary. For encoding, `octet` is the pair's second half still owed to the output, and for decoding, `pending` means the last input octet was a CR.
+    struct NetasciiCarry {
+        tftp_u8 octet;
+        bool pending;
+    };
+
+    struct NetasciiStep {
+        std::size_t consumed;
+        std::size_t produced;
+    };
+
+    /// NOTE: vector kernels copy `width` octets and give a bitmask of those equal to `a` or `b`. The plain one has no fast path.
+    struct ScalarScan {
+        static constexpr std::size_t width = 0;
+    };
+
+#if defined(__SSE2__)
+    struct Sse2Scan {
+        static constexpr std::size_t width = 16;
+
+        [[nodiscard]] static unsigned int copyAndMask(const tftp_u8* source, tftp_u8* target, tftp_u8 a, tftp_u8 b) noexcept {
+            const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+            const auto hits = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(a))), _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(b))));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(target), block);
+
+            return static_cast<unsigned int>(_mm_movemask_epi8(hits));
+        }
+    };
+#endif
+
+#if defined(__x86_64__)
+    /// NOTE: built for AVX2 regardless of the compiler flags, and only picked once the CPU reports it at runtime.
+    struct Avx2Scan {
+        static constexpr std::size_t width = 32;
+
+        [[nodiscard]] [[gnu::target("avx2")]] static unsigned int copyAndMask(const tftp_u8* source, tftp_u8* target, tftp_u8 a, tftp_u8 b) noexcept {
+            const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+            const auto hits = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(static_cast<char>(a))), _mm256_cmpeq_epi8(block, _mm256_set1_epi8(static_cast<char>(b))));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(target), block);
+
+            return static_cast<unsigned int>(_mm256_movemask_epi8(hits));
+        }
+    };
+#endif
+
+    /**
+     * @brief Translates local text to netascii: LF becomes CR LF and CR becomes CR NUL. Stops once `target` is full or `source` is used up, so a block's output never overruns it, and the carry picks up where it stopped.
+     */
+    template <typename Scan>
+    [[nodiscard]] NetasciiStep encodeNetasciiWith(OctetSpan source, tftp_u8* target, std::size_t target_size, NetasciiCarry& carry) noexcept {
+        const auto* source_ptr = source.data();
+        const auto source_size = source.size();
+        auto in_pos = 0UL;
+        auto out_pos = 0UL;
+
+        while (out_pos < target_size) {
+            if (carry.pending) {
+                target[out_pos++] = carry.octet;
+                carry.pending = false;
+                continue;
+            }
+
+            /// NOTE: plain text gets copied a vector at a time, and a run only breaks at the first CR or LF.
+            if constexpr (Scan::width > 0) {
+                while (in_pos + Scan::width <= source_size and out_pos + Scan::width <= target_size) {
+                    const auto hit_mask = Scan::copyAndMask(source_ptr + in_pos, target + out_pos, ascii_lf, ascii_cr);
+                    const auto run_n = (hit_mask == 0U) ? Scan::width : static_cast<std::size_t>(std::countr_zero(hit_mask));
+
+                    in_pos += run_n;
+                    out_pos += run_n;
+
+                    if (hit_mask != 0U) {
+                        break;
+                    }
+                }
+            }
+
+            if (in_pos == source_size or out_pos == target_size) {
+                break;
+            }
+
+            const auto octet = source_ptr[in_pos++];
+
+            if (octet == ascii_lf) {
+                target[out_pos++] = ascii_cr;
+                carry = {ascii_lf, true};
+            } else if (octet == ascii_cr) {
+                target[out_pos++] = ascii_cr;
+                carry = {ascii_nul, true};
+            } else {
+                target[out_pos++] = octet;
+            }
+        }
+
+        return {in_pos, out_pos};
+    }
+
+    /**
+     * @brief Translates netascii back to local text: CR LF becomes LF and CR NUL becomes CR. A CR before any other octet is kept as is. `target` needs room for one octet more than `source`, for a CR carried over from the last block.
+     */
+    template <typename Scan>
+    [[nodiscard]] std::size_t decodeNetasciiWith(OctetSpan source, tftp_u8* target, NetasciiCarry& carry) noexcept {
+        const auto* source_ptr = source.data();
+        const auto source_size = source.size();
+        auto in_pos = 0UL;
+        auto out_pos = 0UL;
+
+        while (in_pos < source_size) {
+            if (carry.pending) {
+                const auto octet = source_ptr[in_pos++];
+
+                carry.pending = octet == ascii_cr;
+
+                if (octet == ascii_lf) {
+                    target[out_pos++] = ascii_lf;
+                } else if (octet == ascii_nul or octet == ascii_cr) {
+                    target[out_pos++] = ascii_cr;
+                } else {
+                    target[out_pos++] = ascii_cr;
+                    target[out_pos++] = octet;
+                }
+
+                continue;
+            }
+
+            /// NOTE: output never runs more than one octet ahead of input, so a full vector store always fits.
+            if constexpr (Scan::width > 0) {
+                while (in_pos + Scan::width <= source_size) {
+                    const auto hit_mask = Scan::copyAndMask(source_ptr + in_pos, target + out_pos, ascii_cr, ascii_cr);
+                    const auto run_n = (hit_mask == 0U) ? Scan::width : static_cast<std::size_t>(std::countr_zero(hit_mask));
+
+                    in_pos += run_n;
+                    out_pos += run_n;
+
+                    if (hit_mask != 0U) {
+                        break;
+                    }
+                }
+            }
+
+            if (in_pos == source_size) {
+                break;
+            }
+
+            const auto octet = source_ptr[in_pos++];
+
+            if (octet == ascii_cr) {
+                carry.pending = true;
+            } else {
+                target[out_pos++] = octet;
+            }
+        }
+
+        return out_pos;
+    }
+
+    [[nodiscard]] inline bool hasAvx2() noexcept {
+#if defined(__x86_64__)
+        static const bool temp = __builtin_cpu_supports("avx2");
+        return temp;
+#else
+        return false;
+#endif
+    }
+
+    [[nodiscard]] inline NetasciiStep encodeNetascii(OctetSpan source, tftp_u8* target, std::size_t target_size, NetasciiCarry& carry) noexcept {
+#if defined(__x86_64__)
+        if (hasAvx2()) {
+            return encodeNetasciiWith<Avx2Scan>(source, target, target_size, carry);
+        }
+#endif
+#if defined(__SSE2__)
+        return encodeNetasciiWith<Sse2Scan>(source, target, target_size, carry);
+#else
+        return encodeNetasciiWith<ScalarScan>(source, target, target_size, carry);
+#endif
+    }
+
+    [[nodiscard]] inline std::size_t decodeNetascii(OctetSpan source, tftp_u8* target, NetasciiCarry& carry) noexcept {
+#if defined(__x86_64__)
+        if (hasAvx2()) {
+            return decodeNetasciiWith<Avx2Scan>(source, target, carry);
+        }
+#endif
+#if defined(__SSE2__)
+        return decodeNetasciiWith<Sse2Scan>(source, target, carry);
+#else
+        return decodeNetasciiWith<ScalarScan>(source, target, carry);
+#endif
+    }
+
+    /// NOTE: a CR which ended the transfer had nothing to pair with, so it goes out as is.
+    [[nodiscard]] inline std::size_t finishNetasciiDecode(tftp_u8* target, NetasciiCarry& carry) noexcept {
+        if (not carry.pending) {
+            return 0UL;
+        }
+
+        carry.pending = false;
+        target[0] = ascii_cr;
+
+        return 1UL;
+    }
+}
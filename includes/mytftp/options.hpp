@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "mytftp/types.hpp"
+#include "mytftp/messaging.hpp"
+
+namespace TftpServer::MyTftp {
+    inline const std::string option_name_blksize = "blksize";
+    inline const std::string option_name_windowsize = "windowsize";
+    inline const std::string option_name_tsize = "tsize";
+    inline const std::string option_name_timeout = "timeout";
+    inline const std::string option_name_multicast = "multicast";
+
+    /// NOTE: RFC 7440 bounds for the `windowsize` option.
+    inline constexpr auto min_window_size = 1UL;
+    inline constexpr auto max_window_size = 65535UL;
+
+    /// NOTE: RFC 2349 bounds for the `timeout` option, in seconds.
+    inline constexpr auto min_timeout_secs = 1UL;
+    inline constexpr auto max_timeout_secs = 255UL;
+
+    /// NOTE: server-side caps applied while negotiating, e.g. the block size that fits the path MTU to a peer.
+    struct OptionLimits {
+        std::size_t max_block_size;
+        std::size_t max_window_size;
+        std::optional<std::uintmax_t> file_size;  // for RRQ, reported back through `tsize`
+        bool offer_tsize;  // false for netascii RRQ, whose size on the wire is only known once the whole file got translated
+        bool echo_tsize;  // for WRQ, where the peer's announced size gets acknowledged as is
+        bool offer_multicast;  // for octet RRQ, when the server has groups to stream to
+    };
+
+    struct TransferOptions {
+        std::size_t block_size;
+        std::size_t window_size;
+        std::optional<std::uintmax_t> transfer_size;  // for WRQ, the size the peer announced
+        std::optional<std::chrono::seconds> timeout;
+        bool multicast;  // the peer asked for RFC 2090 multicast, and the server may offer it
+    };
+
+    struct NegotiationResult {
+        TransferOptions options;
+        OptionList accepted;  // goes into the OACK, which is skipped when empty
+    };
+
+    [[nodiscard]] inline std::optional<std::size_t> parseOptionNumber(std::string_view text) noexcept {
+        std::size_t temp = 0;
+        const auto* text_end = text.data() + text.size();
+        const auto [parse_end, parse_error] = std::from_chars(text.data(), text_end, temp);
+
+        if (parse_error != std::errc {} or parse_end != text_end or text.empty()) {
+            return {};
+        }
+
+        return temp;
+    }
+
+    /**
+     * @brief Picks the RFC 2347 options this server honors from a request. Unknown or unusable options are left out of the OACK, which per RFC 2347 means the peer falls back to the defaults for them.
+     */
+    [[nodiscard]] inline NegotiationResult negotiateOptions(const OptionList& requested, const OptionLimits& limits) {
+        NegotiationResult result {
+            .options = {
+                .block_size = default_block_size,
+                .window_size = min_window_size,
+                .transfer_size = {},
+                .timeout = {},
+                .multicast = false
+            },
+            .accepted = {}
+        };
+
+        for (const auto& [name, value] : requested) {
+            /// NOTE: RFC 2090 requests carry an empty value, and the OACK's value names the group of the transfer, so the session fills that in.
+            if (name == option_name_multicast) {
+                result.options.multicast = limits.offer_multicast;
+                continue;
+            }
+
+            const auto number = parseOptionNumber(value);
+
+            if (not number.has_value()) {
+                continue;
+            }
+
+            if (name == option_name_blksize and number.value() >= min_block_size) {
+                /// NOTE: RFC 2348 lets the server answer with a smaller block size than requested, so it gets clamped to what the path can carry.
+                const auto chosen_size = std::min({number.value(), max_block_size, limits.max_block_size});
+
+                result.options.block_size = chosen_size;
+                result.accepted.push_back({option_name_blksize, std::to_string(chosen_size)});
+            } else if (name == option_name_windowsize and number.value() >= min_window_size) {
+                /// NOTE: RFC 7440 also allows answering with a smaller window, which bounds the blocks a session keeps in flight.
+                const auto chosen_size = std::min({number.value(), max_window_size, limits.max_window_size});
+
+                result.options.window_size = chosen_size;
+                result.accepted.push_back({option_name_windowsize, std::to_string(chosen_size)});
+            } else if (name == option_name_tsize and limits.offer_tsize and (limits.echo_tsize or limits.file_size.has_value())) {
+                /// NOTE: per RFC 2349, an RRQ peer sends 0 and learns the file size from the OACK, while a WRQ peer announces its upload size. An RRQ whose size is unknown leaves tsize out, since echoing the peer's 0 would claim an empty file.
+                const auto reported_size = limits.echo_tsize ? number.value() : limits.file_size.value();
+
+                result.options.transfer_size = reported_size;
+                result.accepted.push_back({option_name_tsize, std::to_string(reported_size)});
+            } else if (name == option_name_timeout and number.value() >= min_timeout_secs and number.value() <= max_timeout_secs) {
+                result.options.timeout = std::chrono::seconds {number.value()};
+                result.accepted.push_back({option_name_timeout, value});
+            }
+        }
+
+        return result;
+    }
+}
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <variant>
+#include <vector>
 
 namespace TftpServer::MyTftp {
     enum class Opcode : unsigned char {
@@ -10,6 +11,7 @@ namespace TftpServer::MyTftp {
         data,
         ack,
         err,
+        oack,
         none,
         last = none
     };
@@ -32,14 +34,24 @@ namespace TftpServer::MyTftp {
         unknown_tid,
         file_already_exists,
         no_user,
-        last = no_user
+        bad_options,
+        last = bad_options
     };
 
     struct DudPayload {};
 
+    /// NOTE: RFC 2347 options trail the mode string as NUL-terminated name / value pairs. Names are stored in lowercase since they match case-insensitively.
+    struct OptionEntry {
+        std::string name;
+        std::string value;
+    };
+
+    using OptionList = std::vector<OptionEntry>;
+
     struct RWPayload {
         std::string filename;
         DataMode mode;
+        OptionList options;
     };
 
     struct DataPayload {
@@ -56,8 +68,12 @@ namespace TftpServer::MyTftp {
         std::string message;
     };
 
+    struct OAckPayload {
+        OptionList options;
+    };
+
     struct Message {
         Opcode op;
-        std::variant<DudPayload, RWPayload, DataPayload, AckPayload, ErrorPayload> payload;
+        std::variant<DudPayload, RWPayload, DataPayload, AckPayload, ErrorPayload, OAckPayload> payload;
     };
 }
\ No newline at end of file
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <variant>
+#include "mybsock/buffers.hpp"
+#include "mytftp/types.hpp"
+#include "mytftp/messaging.hpp"
+
+namespace TftpServer::MyTftp {
+    using OctetSpan = std::span<const tftp_u8>;
+
+    struct RequestView {
+        std::string_view filename;
+        std::string_view mode;
+        OctetSpan options;  // raw name / value pairs, walked with `nextOptionView`
+    };
+
+    struct DataView {
+        tftp_u16 block_n;
+        OctetSpan data;
+    };
+
+    struct AckView {
+        tftp_u16 block_n;
+    };
+
+    struct ErrorView {
+        ErrorCode error;
+        std::string_view message;
+    };
+
+    struct OAckView {
+        OctetSpan options;
+    };
+
+    /// NOTE: names keep the case they had on the wire, so callers compare them case-insensitively.
+    struct OptionView {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    /**
+     * @brief Non-owning counterpart of `Message`, whose fields point straight into the parsed packet. Parsing one never allocates, but it is only valid while the packet's buffer keeps its contents.
+     */
+    struct MessageView {
+        Opcode op;
+        std::variant<DudPayload, RequestView, DataView, AckView, ErrorView, OAckView> payload;
+    };
+
+    [[nodiscard]] inline HelperResult<tftp_u16> viewU16(OctetSpan packet, std::size_t begin) noexcept {
+        tftp_u16 temp = 0;
+
+        if (begin + 2UL > packet.size()) {
+            return {0, dud_payload_num};
+        }
+
+        std::memcpy(&temp, packet.data() + begin, 2UL);
+
+        return {ntohs(temp), begin + 2UL};
+    }
+
+    /// NOTE: unlike `readText`, the terminator is required, since a view cannot hold a string cut off by the packet's end.
+    [[nodiscard]] inline HelperResult<std::string_view> viewText(OctetSpan packet, std::size_t begin) noexcept {
+        if (begin >= packet.size()) {
+            return {{}, dud_payload_num};
+        }
+
+        const auto* text_ptr = packet.data() + begin;
+        const auto* nul_ptr = static_cast<const tftp_u8*>(std::memchr(text_ptr, '\0', packet.size() - begin));
+
+        if (nul_ptr == nullptr) {
+            return {{}, dud_payload_num};
+        }
+
+        const auto text_length = static_cast<std::size_t>(nul_ptr - text_ptr);
+
+        return {
+            std::string_view {reinterpret_cast<const char*>(text_ptr), text_length},
+            begin + text_length + 1UL
+        };
+    }
+
+    /// NOTE: gives the option at `begin` and the offset of the next one. An offset of `dud_payload_num` means the list is malformed, while one at `options.size()` means it ended.
+    [[nodiscard]] inline HelperResult<OptionView> nextOptionView(OctetSpan options, std::size_t begin) noexcept {
+        const auto [name, pos_1] = viewText(options, begin);
+        const auto [value, pos_2] = viewText(options, pos_1);
+
+        if (pos_1 == dud_payload_num or pos_2 == dud_payload_num or name.empty()) {
+            return {{}, dud_payload_num};
+        }
+
+        return {{name, value}, pos_2};
+    }
+
+    [[nodiscard]] inline bool isOptionListValid(OctetSpan options) noexcept {
+        auto read_offset = 0UL;
+
+        while (read_offset < options.size()) {
+            read_offset = nextOptionView(options, read_offset).current_pos;
+        }
+
+        return read_offset == options.size();
+    }
+
+    [[nodiscard]] inline MessageView parseMessageView(OctetSpan packet) noexcept {
+        const auto [opcode, pos_0] = viewU16(packet, 0UL);
+        const auto opcode_enum_v = static_cast<Opcode>(opcode);
+
+        if (pos_0 == dud_payload_num) {
+            return { Opcode::none, DudPayload {} };
+        }
+
+        if (opcode_enum_v == Opcode::data) {
+            const auto [block_n, pos_1] = viewU16(packet, pos_0);
+
+            if (pos_1 == dud_payload_num) {
+                return { Opcode::none, DudPayload {} };
+            }
+
+            return { opcode_enum_v, DataView {block_n, packet.subspan(pos_1)} };
+        } else if (opcode_enum_v == Opcode::ack) {
+            const auto [block_n, pos_1] = viewU16(packet, pos_0);
+
+            if (pos_1 == dud_payload_num) {
+                return { Opcode::none, DudPayload {} };
+            }
+
+            return { opcode_enum_v, AckView {block_n} };
+        } else if (opcode_enum_v == Opcode::err) {
+            const auto [raw_errcode, pos_1] = viewU16(packet, pos_0);
+            const auto [message, pos_2] = viewText(packet, pos_1);
+
+            /// NOTE: like `parsePayload`, a garbled ERROR still counts as one, as the peer gave up either way.
+            if (pos_1 == dud_payload_num or pos_2 == dud_payload_num) {
+                return { opcode_enum_v, ErrorView {ErrorCode::not_defined, "Message decoding failed!"} };
+            }
+
+            return { opcode_enum_v, ErrorView {static_cast<ErrorCode>(raw_errcode), message} };
+        } else if (opcode_enum_v == Opcode::rrq or opcode_enum_v == Opcode::wrq) {
+            const auto [filename, pos_1] = viewText(packet, pos_0);
+            const auto [mode, pos_2] = viewText(packet, pos_1);
+
+            if (pos_1 == dud_payload_num or pos_2 == dud_payload_num or not isOptionListValid(packet.subspan(pos_2))) {
+                return { Opcode::none, DudPayload {} };
+            }
+
+            return { opcode_enum_v, RequestView {filename, mode, packet.subspan(pos_2)} };
+        } else if (opcode_enum_v == Opcode::oack) {
+            if (not isOptionListValid(packet.subspan(pos_0))) {
+                return { Opcode::none, DudPayload {} };
+            }
+
+            return { opcode_enum_v, OAckView {packet.subspan(pos_0)} };
+        }
+
+        return { Opcode::none, DudPayload {} };
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] MessageView parseMessageView(const Buffer& source) noexcept {
+        return parseMessageView(OctetSpan {reinterpret_cast<const tftp_u8*>(source.getPtr()), source.getLength()});
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] HelperResult<bool> writeOctets(Buffer& target, std::size_t begin, OctetSpan octets) noexcept {
+        if (begin + octets.size() > target.getSize()) {
+            return { false, dud_payload_num };
+        }
+
+        if (not octets.empty()) {
+            std::memcpy(target.getPtr() + begin, octets.data(), octets.size());
+        }
+
+        return { true, begin + octets.size() };
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] HelperResult<bool> writeTextView(Buffer& target, std::size_t begin, std::string_view value) noexcept {
+        if (begin + value.size() >= target.getSize()) {
+            return { false, dud_payload_num };
+        }
+
+        std::memcpy(target.getPtr() + begin, value.data(), value.size());
+        target.getPtr()[begin + value.size()] = typename Buffer::value_type {};
+
+        return { true, begin + value.size() + 1UL };
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializeAckView(Buffer& target, tftp_u16 block_n) noexcept {
+        const auto [field_0_ok, pos_0] = writeU16(target, 0UL, static_cast<tftp_u16>(Opcode::ack));
+        const auto [field_1_ok, pos_1] = writeU16(target, pos_0, block_n);
+
+        target.markLength((field_0_ok and field_1_ok) ? pos_1 : 0UL);
+
+        return field_0_ok and field_1_ok;
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializeDataView(Buffer& target, tftp_u16 block_n, OctetSpan data) noexcept {
+        const auto [field_0_ok, pos_0] = writeU16(target, 0UL, static_cast<tftp_u16>(Opcode::data));
+        const auto [field_1_ok, pos_1] = writeU16(target, pos_0, block_n);
+        const auto [field_2_ok, pos_2] = writeOctets(target, pos_1, data);
+
+        target.markLength((field_0_ok and field_1_ok and field_2_ok) ? pos_2 : 0UL);
+
+        return field_0_ok and field_1_ok and field_2_ok;
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializeErrorView(Buffer& target, ErrorCode error, std::string_view message) noexcept {
+        const auto [field_0_ok, pos_0] = writeU16(target, 0UL, static_cast<tftp_u16>(Opcode::err));
+        const auto [field_1_ok, pos_1] = writeU16(target, pos_0, static_cast<tftp_u16>(error));
+        const auto [field_2_ok, pos_2] = writeTextView(target, pos_1, message);
+
+        target.markLength((field_0_ok and field_1_ok and field_2_ok) ? pos_2 : 0UL);
+
+        return field_0_ok and field_1_ok and field_2_ok;
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializeRequestView(Buffer& target, Opcode op, const RequestView& request) noexcept {
+        const auto [field_0_ok, pos_0] = writeU16(target, 0UL, static_cast<tftp_u16>(op));
+        const auto [field_1_ok, pos_1] = writeTextView(target, pos_0, request.filename);
+        const auto [field_2_ok, pos_2] = writeTextView(target, pos_1, request.mode);
+        const auto [field_3_ok, pos_3] = writeOctets(target, pos_2, request.options);
+        const auto all_ok = field_0_ok and field_1_ok and field_2_ok and field_3_ok;
+
+        target.markLength(all_ok ? pos_3 : 0UL);
+
+        return all_ok;
+    }
+
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializeOAckView(Buffer& target, const OAckView& oack) noexcept {
+        const auto [field_0_ok, pos_0] = writeU16(target, 0UL, static_cast<tftp_u16>(Opcode::oack));
+        const auto [field_1_ok, pos_1] = writeOctets(target, pos_0, oack.options);
+
+        target.markLength((field_0_ok and field_1_ok) ? pos_1 : 0UL);
+
+        return field_0_ok and field_1_ok;
+    }
+
+    /// NOTE: writes the message in place with one copy per field, the counterpart of `serializeMessage` for views.
+    template <MyBSock::OctetBuffer Buffer>
+    [[nodiscard]] bool serializeMessageView(Buffer& target, const MessageView& msg) noexcept {
+        const auto msg_opcode = msg.op;
+
+        if (msg_opcode == Opcode::rrq or msg_opcode == Opcode::wrq) {
+            return serializeRequestView(target, msg_opcode, std::get<RequestView>(msg.payload));
+        } else if (msg_opcode == Opcode::data) {
+            const auto& [block_n, data] = std::get<DataView>(msg.payload);
+            return serializeDataView(target, block_n, data);
+        } else if (msg_opcode == Opcode::ack) {
+            return serializeAckView(target, std::get<AckView>(msg.payload).block_n);
+        } else if (msg_opcode == Opcode::err) {
+            const auto& [error, message] = std::get<ErrorView>(msg.payload);
+            return serializeErrorView(target, error, message);
+        } else if (msg_opcode == Opcode::oack) {
+            return serializeOAckView(target, std::get<OAckView>(msg.payload));
+        }
+
+        target.markLength(0);
+        return false;
+    }
+}
@@ -0,0 +1,544 @@
+/**
+ * @file bench.cpp
+ * @brief Implements a load generator which runs many TFTP clients at once against a server over loopback.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <arpa/inet.h>
+#include "mybsock/netconfig.hpp"
+#include "mybsock/sockets.hpp"
+#include "mytftp/options.hpp"
+#include "mytftp/views.hpp"
+
+namespace TftpServer::Bench {
+    using BenchClock = std::chrono::steady_clock;
+    using PacketBuffer = MyBSock::FixedBuffer<MyTftp::tftp_u8, MyTftp::max_packet_size>;
+
+    static constexpr auto default_client_count = 4UL;
+    static constexpr auto default_transfer_count = 16UL;
+    static constexpr auto default_file_size = 1024UL * 1024UL;
+    static constexpr auto default_timeout_ms = 1000UL;
+    /// NOTE: unanswered retransmits before a transfer counts as failed, matching the server's own limit.
+    static constexpr auto max_client_retries = 8UL;
+    static constexpr auto bytes_per_mb = 1024.0 * 1024.0;
+    static constexpr const char* default_host_cstr = "127.0.0.1";
+    static constexpr const char* ephemeral_port_cstr = "0";
+    static constexpr auto dud_socket_fd = -1;
+    static constexpr const char* bench_usage = "usage: ./tftp-bench <server port> [--op rrq|wrq] [--clients <n>] [--transfers <n per client>] [--size <bytes>] [--blksize <n>] [--windowsize <n>] [--timeout-ms <n>] [--host <ipv4>]\n";
+
+    enum class BenchOp {
+        rrq,
+        wrq
+    };
+
+    struct BenchConfig {
+        const char* host_cstr;
+        const char* port_cstr;
+        BenchOp op;
+        std::size_t client_count;
+        std::size_t transfer_count;  // per client
+        std::size_t file_size;
+        std::size_t block_size;
+        std::size_t window_size;
+        std::chrono::milliseconds timeout;
+    };
+
+    struct TransferOutcome {
+        bool ok;
+        std::size_t bytes;
+        BenchClock::duration elapsed;
+    };
+
+    struct ClientReport {
+        std::vector<BenchClock::duration> latencies;  // successful transfers only
+        std::size_t bytes;
+        std::size_t failures;
+    };
+
+    [[nodiscard]] static std::optional<std::size_t> parseCount(std::string_view text) noexcept {
+        std::size_t temp = 0;
+        const auto* text_end = text.data() + text.size();
+        const auto [parse_end, parse_error] = std::from_chars(text.data(), text_end, temp);
+
+        if (parse_error != std::errc {} or parse_end != text_end or text.empty()) {
+            return {};
+        }
+
+        return temp;
+    }
+
+    [[nodiscard]] static bool isOptionNamed(std::string_view name, std::string_view expected) noexcept {
+        return std::ranges::equal(name, expected, [](char lhs, char rhs) {
+            return std::tolower(static_cast<unsigned char>(lhs)) == rhs;
+        });
+    }
+
+    [[nodiscard]] static std::optional<BenchConfig> parseBenchConfig(int argc, char* argv[]) {
+        if (argc < 2 or not parseCount(argv[1]).has_value()) {
+            return {};
+        }
+
+        BenchConfig temp {
+            .host_cstr = default_host_cstr,
+            .port_cstr = argv[1],
+            .op = BenchOp::rrq,
+            .client_count = default_client_count,
+            .transfer_count = default_transfer_count,
+            .file_size = default_file_size,
+            .block_size = MyTftp::default_block_size,
+            .window_size = MyTftp::min_window_size,
+            .timeout = std::chrono::milliseconds {default_timeout_ms}
+        };
+
+        for (auto arg_index = 2; arg_index < argc; arg_index += 2) {
+            const std::string_view flag {argv[arg_index]};
+
+            if (arg_index + 1 >= argc) {
+                return {};
+            }
+
+            const std::string_view value {argv[arg_index + 1]};
+            const auto number = parseCount(value);
+
+            if (flag == "--op" and (value == "rrq" or value == "wrq")) {
+                temp.op = (value == "wrq") ? BenchOp::wrq : BenchOp::rrq;
+            } else if (flag == "--host" and not value.empty()) {
+                temp.host_cstr = argv[arg_index + 1];
+            } else if (flag == "--clients" and number.value_or(0UL) > 0UL) {
+                temp.client_count = number.value();
+            } else if (flag == "--transfers" and number.value_or(0UL) > 0UL) {
+                temp.transfer_count = number.value();
+            } else if (flag == "--size" and number.has_value()) {
+                temp.file_size = number.value();
+            } else if (flag == "--blksize" and number.has_value() and number.value() >= MyTftp::min_block_size and number.value() <= MyTftp::max_block_size) {
+                temp.block_size = number.value();
+            } else if (flag == "--windowsize" and number.has_value() and number.value() >= MyTftp::min_window_size and number.value() <= MyTftp::max_window_size) {
+                temp.window_size = number.value();
+            } else if (flag == "--timeout-ms" and number.value_or(0UL) > 0UL) {
+                temp.timeout = std::chrono::milliseconds {number.value()};
+            } else {
+                return {};
+            }
+        }
+
+        return temp;
+    }
+
+    /**
+     * @brief One simulated client, which runs its transfers back to back. It speaks just enough TFTP to drive the server: `blksize` and `windowsize` negotiation, windowed DATA and ACKs, and timeouts with retransmits.
+     */
+    class BenchClient {
+    private:
+        MyBSock::UDPServerSocket m_socket;
+        MyBSock::IOResult m_server;  // the listener until a reply pins the server's transfer ID
+        sockaddr_in m_listener;
+        PacketBuffer m_rx_buffer;
+        PacketBuffer m_tx_buffer;  // keeps the last request or ACK for re-sending
+        std::string m_request_options;
+        const BenchConfig& m_config;
+
+        /// NOTE: only asks for options which differ from the RFC 1350 defaults, so a plain request stays plain.
+        void prepareOptions() {
+            if (m_config.block_size != MyTftp::default_block_size) {
+                m_request_options.append(MyTftp::option_name_blksize).push_back('\0');
+                m_request_options.append(std::to_string(m_config.block_size)).push_back('\0');
+            }
+
+            if (m_config.window_size != MyTftp::min_window_size) {
+                m_request_options.append(MyTftp::option_name_windowsize).push_back('\0');
+                m_request_options.append(std::to_string(m_config.window_size)).push_back('\0');
+            }
+        }
+
+        [[nodiscard]] bool sendPacket(const PacketBuffer& packet) {
+            return m_socket.sendTo(packet, packet.getLength(), m_server).status == MyBSock::IOStatus::ok;
+        }
+
+        /// NOTE: waits up to the timeout for a reply from the server's host, and pins the port of the first one as the transfer ID. Strays from other ports get skipped.
+        [[nodiscard]] std::optional<MyTftp::MessageView> awaitReply(bool& tid_pinned) {
+            const auto deadline = BenchClock::now() + m_config.timeout;
+
+            while (true) {
+                const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - BenchClock::now());
+
+                if (remaining.count() <= 0) {
+                    return {};
+                }
+
+                pollfd poll_entry {m_socket.getFd(), POLLIN, 0};
+
+                if (poll(&poll_entry, 1, static_cast<int>(remaining.count()) + 1) <= 0) {
+                    continue;
+                }
+
+                const auto [peer, status] = m_socket.recieveFrom(m_rx_buffer, m_rx_buffer.getSize());
+
+                if (status != MyBSock::IOStatus::ok or peer.sin_addr.s_addr != m_listener.sin_addr.s_addr) {
+                    continue;
+                }
+
+                if (not tid_pinned) {
+                    m_server.data.sin_port = peer.sin_port;
+                    tid_pinned = true;
+                } else if (peer.sin_port != m_server.data.sin_port) {
+                    continue;
+                }
+
+                return MyTftp::parseMessageView(m_rx_buffer);
+            }
+        }
+
+        void applyOAck(const MyTftp::OAckView& oack, std::size_t& block_size, std::size_t& window_size) const noexcept {
+            auto read_pos = 0UL;
+
+            while (read_pos < oack.options.size()) {
+                const auto [option, next_pos] = MyTftp::nextOptionView(oack.options, read_pos);
+                const auto number = parseCount(option.value);
+
+                if (number.has_value() and isOptionNamed(option.name, MyTftp::option_name_blksize)) {
+                    block_size = number.value();
+                } else if (number.has_value() and isOptionNamed(option.name, MyTftp::option_name_windowsize)) {
+                    window_size = number.value();
+                }
+
+                read_pos = next_pos;
+            }
+        }
+
+        /// NOTE: each transfer gets a fresh ephemeral port as its transfer ID, as RFC 1350 asks. Reusing one would look like a duplicate request to a server still lingering on the previous transfer.
+        [[nodiscard]] bool openSocket() {
+            MyBSock::SocketGenerator socket_gen {ephemeral_port_cstr};
+            auto socket_fd = socket_gen();
+
+            m_socket = MyBSock::UDPServerSocket {socket_fd.value_or(dud_socket_fd)};
+
+            return m_socket.isUsable();
+        }
+
+        [[nodiscard]] bool sendRequest(MyTftp::Opcode op, std::string_view filename) {
+            if (not openSocket()) {
+                return false;
+            }
+
+            const MyTftp::RequestView request {
+                filename,
+                MyTftp::mode_name_octet,
+                {reinterpret_cast<const MyTftp::tftp_u8*>(m_request_options.data()), m_request_options.size()}
+            };
+
+            m_server.data = m_listener;
+
+            return MyTftp::serializeRequestView(m_tx_buffer, op, request) and sendPacket(m_tx_buffer);
+        }
+
+        [[nodiscard]] bool sendAck(std::size_t block_index) {
+            return MyTftp::serializeAckView(m_tx_buffer, static_cast<MyTftp::tftp_u16>(block_index)) and sendPacket(m_tx_buffer);
+        }
+
+    public:
+        BenchClient(const BenchConfig& config, const sockaddr_in& listener)
+        : m_socket {}, m_server {listener, MyBSock::IOStatus::ok}, m_listener {listener}, m_rx_buffer {}, m_tx_buffer {}, m_request_options {}, m_config {config} {
+            prepareOptions();
+        }
+
+        /// NOTE: ACKs each full window and the final short block, and answers a gap with one ACK of the last in-order block so the server restarts its window from there.
+        [[nodiscard]] TransferOutcome runRead(std::string_view filename) {
+            const auto started_at = BenchClock::now();
+            auto block_size = MyTftp::default_block_size;
+            auto window_size = MyTftp::min_window_size;
+            auto next_block = 1UL;
+            auto window_fill = 0UL;
+            auto gap_acked = false;
+            auto tid_pinned = false;
+            auto retries = 0UL;
+            auto bytes = 0UL;
+
+            if (not sendRequest(MyTftp::Opcode::rrq, filename)) {
+                return {false, 0UL, BenchClock::now() - started_at};
+            }
+
+            while (true) {
+                const auto reply = awaitReply(tid_pinned);
+
+                if (not reply.has_value()) {
+                    if (++retries > max_client_retries or not sendPacket(m_tx_buffer)) {
+                        return {false, bytes, BenchClock::now() - started_at};
+                    }
+
+                    continue;
+                }
+
+                if (reply->op == MyTftp::Opcode::oack and next_block == 1UL) {
+                    applyOAck(std::get<MyTftp::OAckView>(reply->payload), block_size, window_size);
+                    retries = 0UL;
+
+                    if (not sendAck(0UL)) {
+                        return {false, bytes, BenchClock::now() - started_at};
+                    }
+                } else if (reply->op == MyTftp::Opcode::data) {
+                    const auto& [block_n, data] = std::get<MyTftp::DataView>(reply->payload);
+
+                    if (block_n != static_cast<MyTftp::tftp_u16>(next_block)) {
+                        if (not gap_acked and not sendAck(next_block - 1UL)) {
+                            return {false, bytes, BenchClock::now() - started_at};
+                        }
+
+                        gap_acked = true;
+                        window_fill = 0UL;
+                        continue;
+                    }
+
+                    bytes += data.size();
+                    next_block++;
+                    window_fill++;
+                    gap_acked = false;
+                    retries = 0UL;
+
+                    const auto last_block = data.size() < block_size;
+
+                    if ((last_block or window_fill == window_size) and not sendAck(next_block - 1UL)) {
+                        return {false, bytes, BenchClock::now() - started_at};
+                    }
+
+                    if (last_block) {
+                        return {true, bytes, BenchClock::now() - started_at};
+                    }
+
+                    if (window_fill == window_size) {
+                        window_fill = 0UL;
+                    }
+                } else if (reply->op == MyTftp::Opcode::err) {
+                    return {false, bytes, BenchClock::now() - started_at};
+                }
+            }
+        }
+
+        /// NOTE: sends a window past the last ACKed block, and sends the next one from just past whatever block an ACK names, so a partial ACK after a loss restarts the window right away. A timeout re-sends the current window.
+        [[nodiscard]] TransferOutcome runWrite(std::string_view filename, MyTftp::OctetSpan contents) {
+            const auto started_at = BenchClock::now();
+            auto block_size = MyTftp::default_block_size;
+            auto window_size = MyTftp::min_window_size;
+            auto acked_block = 0UL;
+            auto sent_block = 0UL;
+            auto accepted = false;
+            auto tid_pinned = false;
+            auto retries = 0UL;
+
+            /// NOTE: a size which is a multiple of the block size still ends with an empty block.
+            const auto lastBlock = [&]() noexcept {
+                return contents.size() / block_size + 1UL;
+            };
+
+            const auto sendWindow = [&](std::size_t first_block) {
+                const auto end_block = std::min(first_block + window_size, lastBlock() + 1UL);
+
+                for (auto block_index = first_block; block_index < end_block; block_index++) {
+                    const auto offset = (block_index - 1UL) * block_size;
+                    const auto chunk = contents.subspan(offset, std::min(block_size, contents.size() - offset));
+
+                    if (not MyTftp::serializeDataView(m_tx_buffer, static_cast<MyTftp::tftp_u16>(block_index), chunk) or not sendPacket(m_tx_buffer)) {
+                        return false;
+                    }
+
+                    sent_block = block_index;
+                }
+
+                return true;
+            };
+
+            if (not sendRequest(MyTftp::Opcode::wrq, filename)) {
+                return {false, 0UL, BenchClock::now() - started_at};
+            }
+
+            while (true) {
+                const auto reply = awaitReply(tid_pinned);
+
+                if (not reply.has_value()) {
+                    const auto resent_ok = accepted ? sendWindow(acked_block + 1UL) : sendPacket(m_tx_buffer);
+
+                    if (++retries > max_client_retries or not resent_ok) {
+                        return {false, acked_block * block_size, BenchClock::now() - started_at};
+                    }
+
+                    continue;
+                }
+
+                if (reply->op == MyTftp::Opcode::err) {
+                    return {false, acked_block * block_size, BenchClock::now() - started_at};
+                }
+
+                if (not accepted) {
+                    if (reply->op == MyTftp::Opcode::oack) {
+                        applyOAck(std::get<MyTftp::OAckView>(reply->payload), block_size, window_size);
+                    } else if (reply->op != MyTftp::Opcode::ack or std::get<MyTftp::AckView>(reply->payload).block_n != 0U) {
+                        continue;
+                    }
+
+                    accepted = true;
+                    retries = 0UL;
+
+                    if (not sendWindow(1UL)) {
+                        return {false, 0UL, BenchClock::now() - started_at};
+                    }
+
+                    continue;
+                }
+
+                if (reply->op != MyTftp::Opcode::ack and reply->op != MyTftp::Opcode::oack) {
+                    continue;
+                }
+
+                /// NOTE: a repeated OACK, or with windowing a repeated ACK, means the server timed out waiting for lost blocks, so the window goes out again from there.
+                const auto block_n = (reply->op == MyTftp::Opcode::ack) ? std::get<MyTftp::AckView>(reply->payload).block_n : MyTftp::tftp_u16 {0};
+                const auto advance_n = static_cast<std::size_t>(static_cast<MyTftp::tftp_u16>(block_n - static_cast<MyTftp::tftp_u16>(acked_block)));
+                const auto resume_asked = advance_n == 0UL and (reply->op == MyTftp::Opcode::oack or window_size > MyTftp::min_window_size);
+
+                if (resume_asked) {
+                    if (++retries > max_client_retries or not sendWindow(acked_block + 1UL)) {
+                        return {false, acked_block * block_size, BenchClock::now() - started_at};
+                    }
+
+                    continue;
+                }
+
+                if (advance_n == 0UL or advance_n > sent_block - acked_block) {
+                    continue;
+                }
+
+                acked_block += advance_n;
+                retries = 0UL;
+
+                if (acked_block == lastBlock()) {
+                    return {true, contents.size(), BenchClock::now() - started_at};
+                }
+
+                if (not sendWindow(acked_block + 1UL)) {
+                    return {false, acked_block * block_size, BenchClock::now() - started_at};
+                }
+            }
+        }
+    };
+
+    [[nodiscard]] static std::vector<MyTftp::tftp_u8> makeContents(std::size_t size) {
+        std::vector<MyTftp::tftp_u8> temp(size);
+
+        for (auto octet_index = 0UL; octet_index < size; octet_index++) {
+            temp[octet_index] = static_cast<MyTftp::tftp_u8>((octet_index * 131UL) >> 3);
+        }
+
+        return temp;
+    }
+
+    /// NOTE: nearest-rank percentile over sorted samples.
+    [[nodiscard]] static double percentileMs(const std::vector<BenchClock::duration>& sorted, double fraction) noexcept {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+
+        const auto rank = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size()) + 0.999999);
+        const auto index = std::min(std::max(rank, 1UL), sorted.size()) - 1UL;
+
+        return std::chrono::duration<double, std::milli> {sorted[index]}.count();
+    }
+
+    static void runClient(const BenchConfig& config, const sockaddr_in& listener, std::size_t client_index, MyTftp::OctetSpan contents, std::string_view read_name, ClientReport& report) {
+        BenchClient client {config, listener};
+        const auto write_name = std::format("bench-upload-{}.bin", client_index);
+
+        report.latencies.reserve(config.transfer_count);
+
+        for (auto transfer_index = 0UL; transfer_index < config.transfer_count; transfer_index++) {
+            const auto [ok, bytes, elapsed] = (config.op == BenchOp::rrq) ? client.runRead(read_name) : client.runWrite(write_name, contents);
+
+            report.bytes += bytes;
+
+            if (ok) {
+                report.latencies.push_back(elapsed);
+            } else {
+                report.failures++;
+            }
+        }
+    }
+
+    [[nodiscard]] static int runBench(const BenchConfig& config) {
+        sockaddr_in listener {};
+        listener.sin_family = AF_INET;
+        listener.sin_port = htons(static_cast<in_port_t>(std::atoi(config.port_cstr)));
+
+        if (inet_pton(AF_INET, config.host_cstr, &listener.sin_addr) != 1) {
+            std::print(stderr, "tftp-bench: bad host address {}\n", config.host_cstr);
+            return 1;
+        }
+
+        const auto contents = makeContents(config.file_size);
+        const auto read_name = std::format("bench-{}.bin", config.file_size);
+
+        /// NOTE: reads need a file of the asked size on the server, so one upload seeds it before the clock starts.
+        if (config.op == BenchOp::rrq) {
+            BenchClient seeder {config, listener};
+
+            if (not seeder.runWrite(read_name, contents).ok) {
+                std::print(stderr, "tftp-bench: could not upload {} to seed the reads\n", read_name);
+                return 1;
+            }
+        }
+
+        std::vector<ClientReport> reports(config.client_count, ClientReport {{}, 0UL, 0UL});
+        const auto started_at = BenchClock::now();
+
+        {
+            std::vector<std::jthread> clients;
+            clients.reserve(config.client_count);
+
+            for (auto client_index = 0UL; client_index < config.client_count; client_index++) {
+                clients.emplace_back(runClient, std::cref(config), std::cref(listener), client_index, MyTftp::OctetSpan {contents}, std::string_view {read_name}, std::ref(reports[client_index]));
+            }
+        }
+
+        const auto wall_secs = std::chrono::duration<double> {BenchClock::now() - started_at}.count();
+        std::vector<BenchClock::duration> latencies;
+        auto total_bytes = 0UL;
+        auto failures = 0UL;
+
+        for (const auto& [client_latencies, bytes, client_failures] : reports) {
+            latencies.insert(latencies.end(), client_latencies.begin(), client_latencies.end());
+            total_bytes += bytes;
+            failures += client_failures;
+        }
+
+        std::ranges::sort(latencies);
+
+        const auto mb_per_sec = static_cast<double>(total_bytes) / bytes_per_mb / wall_secs;
+
+        std::print("tftp-bench: {} clients x {} {} transfers of {}B, blksize={}, windowsize={}\n", config.client_count, config.transfer_count, (config.op == BenchOp::rrq) ? "rrq" : "wrq", config.file_size, config.block_size, config.window_size);
+        std::print("transfers: ok={} failed={} in {:.3f}s\n", latencies.size(), failures, wall_secs);
+        std::print("throughput: {:.1f} MiB/s ({:.1f} Mbit/s), {:.1f} transfers/s\n", mb_per_sec, mb_per_sec * bytes_per_mb * 8.0 / 1e6, static_cast<double>(latencies.size()) / wall_secs);
+        std::print("latency: p50={:.3f}ms p99={:.3f}ms p999={:.3f}ms max={:.3f}ms\n", percentileMs(latencies, 0.5), percentileMs(latencies, 0.99), percentileMs(latencies, 0.999), percentileMs(latencies, 1.0));
+
+        return (failures == 0UL) ? 0 : 2;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const auto config = TftpServer::Bench::parseBenchConfig(argc, argv);
+
+    if (not config.has_value()) {
+        std::print(stderr, "Invalid arguments.\n{}", TftpServer::Bench::bench_usage);
+        return 1;
+    }
+
+    return TftpServer::Bench::runBench(config.value());
+}
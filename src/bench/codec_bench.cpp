@@ -0,0 +1,258 @@
+/**
+ * @file codec_bench.cpp
+ * @brief Implements microbenchmarks of the TFTP message codec and packet buffers, printed as one JSON object per line.
+ */
+
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "mytftp/messaging.hpp"
+#include "mytftp/views.hpp"
+#include "bench/alloccount.hpp"
+
+namespace TftpServer::Bench {
+    using namespace TftpServer::MyTftp;
+    using BenchClock = std::chrono::steady_clock;
+    using PacketBuffer = MyBSock::FixedBuffer<tftp_u8, max_packet_size>;
+
+    static constexpr auto default_min_time = std::chrono::milliseconds {200};
+    static constexpr auto warmup_iterations = 1000UL;
+    static constexpr auto first_batch_size = 64UL;
+    static constexpr auto bench_schema_version = 1;
+    static constexpr const char* codec_bench_usage = "usage: ./tftp-codec-bench [--min-ms <n per case>] [--filter <substring of case name>]\n";
+
+    /// NOTE: RFC 1350's default block, a 1500B MTU's block, a jumbo frame's block, and the largest RFC 2348 allows. Zero is the empty last block.
+    static constexpr std::array<std::size_t, 5> data_payload_sizes = {0UL, default_block_size, 1428UL, 8192UL, max_block_size};
+    static constexpr std::array<std::size_t, 3> text_lengths = {8UL, 64UL, 255UL};
+
+    struct CodecBenchConfig {
+        std::chrono::milliseconds min_time;
+        std::string_view filter;
+    };
+
+    /// NOTE: keeps the compiler from dropping a result it can see is unused.
+    template <typename T>
+    void keepAlive(const T& value) noexcept {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    struct CaseResult {
+        std::size_t iterations;
+        double ns_per_packet;
+        double allocs_per_packet;
+    };
+
+    /// NOTE: doubles the batch until one takes at least `min_time`, then reports that batch alone, so the clock's own cost stays negligible.
+    template <typename Body>
+    [[nodiscard]] CaseResult measureCase(Body& body, std::chrono::milliseconds min_time) {
+        for (auto warmup_index = 0UL; warmup_index < warmup_iterations; warmup_index++) {
+            body();
+        }
+
+        auto batch_size = first_batch_size;
+
+        while (true) {
+            const auto allocs_before = allocation_count;
+            const auto started_at = BenchClock::now();
+
+            for (auto iteration = 0UL; iteration < batch_size; iteration++) {
+                body();
+            }
+
+            const auto elapsed = BenchClock::now() - started_at;
+            const auto allocs_n = allocation_count - allocs_before;
+
+            if (elapsed >= min_time) {
+                return {
+                    batch_size,
+                    std::chrono::duration<double, std::nano> {elapsed}.count() / static_cast<double>(batch_size),
+                    static_cast<double>(allocs_n) / static_cast<double>(batch_size)
+                };
+            }
+
+            batch_size *= 2UL;
+        }
+    }
+
+    template <typename Body>
+    void runCase(const CodecBenchConfig& config, std::string_view name, std::string_view opcode, std::size_t payload_bytes, Body body) {
+        if (not config.filter.empty() and name.find(config.filter) == std::string_view::npos) {
+            return;
+        }
+
+        const auto [iterations, ns_per_packet, allocs_per_packet] = measureCase(body, config.min_time);
+
+        std::print("{{\"schema\":{},\"case\":\"{}\",\"opcode\":\"{}\",\"payload_bytes\":{},\"iterations\":{},\"ns_per_packet\":{:.2f},\"allocs_per_packet\":{:.3f}}}\n", bench_schema_version, name, opcode, payload_bytes, iterations, ns_per_packet, allocs_per_packet);
+        std::fflush(stdout);
+    }
+
+    [[nodiscard]] static std::u8string makeBlob(std::size_t size) {
+        std::u8string temp(size, u8'\0');
+
+        for (auto octet_index = 0UL; octet_index < size; octet_index++) {
+            temp[octet_index] = static_cast<char8_t>((octet_index * 131UL) >> 3);
+        }
+
+        return temp;
+    }
+
+    [[nodiscard]] static std::optional<CodecBenchConfig> parseCodecBenchConfig(int argc, char* argv[]) {
+        CodecBenchConfig temp {default_min_time, {}};
+
+        for (auto arg_index = 1; arg_index < argc; arg_index += 2) {
+            const std::string_view flag {argv[arg_index]};
+
+            if (arg_index + 1 >= argc) {
+                return {};
+            }
+
+            const std::string_view value {argv[arg_index + 1]};
+
+            if (flag == "--min-ms") {
+                std::size_t min_ms = 0;
+                const auto [parse_end, parse_error] = std::from_chars(value.data(), value.data() + value.size(), min_ms);
+
+                if (parse_error != std::errc {} or parse_end != value.data() + value.size() or min_ms == 0UL) {
+                    return {};
+                }
+
+                temp.min_time = std::chrono::milliseconds {min_ms};
+            } else if (flag == "--filter") {
+                temp.filter = value;
+            } else {
+                return {};
+            }
+        }
+
+        return temp;
+    }
+
+    /// NOTE: one sample message per opcode, with `payload_bytes` counting the DATA block or the request's filename.
+    [[nodiscard]] static std::vector<std::pair<std::size_t, Message>> makeSampleMessages(Opcode op) {
+        std::vector<std::pair<std::size_t, Message>> temp;
+
+        if (op == Opcode::rrq or op == Opcode::wrq) {
+            for (const auto text_length : text_lengths) {
+                temp.push_back({text_length, {op, RWPayload {std::string(text_length, 'f'), DataMode::octet, {{"blksize", "1428"}, {"windowsize", "16"}, {"tsize", "0"}}}}});
+            }
+        } else if (op == Opcode::data) {
+            for (const auto payload_size : data_payload_sizes) {
+                temp.push_back({payload_size, {op, DataPayload {1U, makeBlob(payload_size)}}});
+            }
+        } else if (op == Opcode::ack) {
+            temp.push_back({0UL, {op, AckPayload {1U}}});
+        } else if (op == Opcode::err) {
+            temp.push_back({15UL, {op, ErrorPayload {ErrorCode::file_not_found, "File not found."}}});
+        } else if (op == Opcode::oack) {
+            temp.push_back({0UL, {op, OAckPayload {{{"blksize", "1428"}, {"windowsize", "16"}, {"tsize", "1048576"}}}}});
+        }
+
+        return temp;
+    }
+
+    [[nodiscard]] static std::string_view toOpcodeName(Opcode op) noexcept {
+        static constexpr std::array<std::string_view, 7> opcode_names = {"none", "rrq", "wrq", "data", "ack", "err", "oack"};
+
+        return opcode_names[(static_cast<std::size_t>(op) < opcode_names.size()) ? static_cast<std::size_t>(op) : 0UL];
+    }
+
+    static void runMessageCases(const CodecBenchConfig& config, PacketBuffer& packet, PacketBuffer& scratch) {
+        static constexpr std::array<Opcode, 6> bench_opcodes = {Opcode::rrq, Opcode::wrq, Opcode::data, Opcode::ack, Opcode::err, Opcode::oack};
+
+        for (const auto op : bench_opcodes) {
+            for (const auto& [payload_bytes, message] : makeSampleMessages(op)) {
+                if (not serializeMessage(packet, message)) {
+                    std::print(stderr, "tftp-codec-bench: could not build a sample {} message\n", toOpcodeName(op));
+                    continue;
+                }
+
+                runCase(config, "parseMessage", toOpcodeName(op), payload_bytes, [&packet] {
+                    const auto parsed = parseMessage(packet);
+                    keepAlive(parsed);
+                });
+
+                runCase(config, "parseMessageView", toOpcodeName(op), payload_bytes, [&packet] {
+                    const auto parsed = parseMessageView(packet);
+                    keepAlive(parsed);
+                });
+
+                runCase(config, "serializeMessage", toOpcodeName(op), payload_bytes, [&scratch, &message] {
+                    const auto written_ok = serializeMessage(scratch, message);
+                    keepAlive(written_ok);
+                });
+
+                const auto view = parseMessageView(packet);
+
+                runCase(config, "serializeMessageView", toOpcodeName(op), payload_bytes, [&scratch, &view] {
+                    const auto written_ok = serializeMessageView(scratch, view);
+                    keepAlive(written_ok);
+                });
+            }
+        }
+    }
+
+    static void runFieldCases(const CodecBenchConfig& config, PacketBuffer& packet, PacketBuffer& scratch) {
+        for (const auto text_length : text_lengths) {
+            const RWPayload request {std::string(text_length, 'f'), DataMode::octet, {}};
+
+            if (not serializeMessage(packet, {Opcode::rrq, request})) {
+                continue;
+            }
+
+            runCase(config, "readText", "rrq", text_length, [&packet] {
+                const auto text = readText(packet, 2UL);
+                keepAlive(text);
+            });
+        }
+
+        for (const auto payload_size : data_payload_sizes) {
+            const auto blob = makeBlob(payload_size);
+
+            if (not serializeMessage(packet, {Opcode::data, DataPayload {1U, blob}})) {
+                continue;
+            }
+
+            runCase(config, "readBlob", "data", payload_size, [&packet, payload_size] {
+                const auto read_blob = readBlob(packet, data_header_size, payload_size);
+                keepAlive(read_blob);
+            });
+
+            runCase(config, "writeBlob", "data", payload_size, [&scratch, &blob] {
+                const auto written = writeBlob(scratch, data_header_size, blob);
+                keepAlive(written);
+            });
+        }
+
+        runCase(config, "FixedBuffer::reset", "none", scratch.getSize(), [&scratch] {
+            scratch.markLength(scratch.getSize());
+            scratch.reset();
+            keepAlive(scratch);
+        });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    using namespace TftpServer::Bench;
+
+    const auto config = parseCodecBenchConfig(argc, argv);
+
+    if (not config.has_value()) {
+        std::print(stderr, "Invalid arguments.\n{}", codec_bench_usage);
+        return 1;
+    }
+
+    PacketBuffer packet;
+    PacketBuffer scratch;
+
+    runMessageCases(config.value(), packet, scratch);
+    runFieldCases(config.value(), packet, scratch);
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+#include <charconv>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <arpa/inet.h>
+#include "driver/config.hpp"
+
+namespace TftpServer::Driver {
+    static constexpr auto min_free_port = 1024;
+    static constexpr auto bytes_per_mb = 1024UL * 1024UL;
+    static constexpr auto bytes_per_mbit = 1'000'000UL / 8UL;
+    static constexpr auto ipv4_bits = 32UL;
+    static constexpr auto max_port = 65535UL;
+
+    [[nodiscard]] static std::optional<std::size_t> parseCount(std::string_view text) noexcept {
+        std::size_t temp = 0;
+        const auto* text_end = text.data() + text.size();
+        const auto [parse_end, parse_error] = std::from_chars(text.data(), text_end, temp);
+
+        if (parse_error != std::errc {} or parse_end != text_end or text.empty()) {
+            return {};
+        }
+
+        return temp;
+    }
+
+    /// NOTE: expects `<ipv4>/<prefix length>=<mbit per second>`, such as `10.1.0.0/16=100`.
+    [[nodiscard]] static std::optional<RateClass> parseRateClass(std::string_view text) {
+        const auto slash_pos = text.find('/');
+        const auto equals_pos = text.find('=');
+
+        if (slash_pos == std::string_view::npos or equals_pos == std::string_view::npos or equals_pos < slash_pos) {
+            return {};
+        }
+
+        const std::string network_text {text.substr(0, slash_pos)};
+        const auto prefix_length = parseCount(text.substr(slash_pos + 1, equals_pos - slash_pos - 1));
+        const auto rate_mbit = parseCount(text.substr(equals_pos + 1));
+        in_addr network {};
+
+        if (inet_pton(AF_INET, network_text.c_str(), &network) != 1 or not prefix_length.has_value() or prefix_length.value() > ipv4_bits or rate_mbit.value_or(0UL) == 0UL) {
+            return {};
+        }
+
+        const auto host_mask = (prefix_length.value() == 0UL) ? 0U : ~0U << (ipv4_bits - prefix_length.value());
+        const auto mask = htonl(static_cast<std::uint32_t>(host_mask));
+
+        return RateClass {network.s_addr & mask, mask, rate_mbit.value() * bytes_per_mbit};
+    }
+
+    /// NOTE: expects `<ipv4 multicast address>:<port>`, such as `239.255.69.1:1758`.
+    [[nodiscard]] static bool parseMulticastGroup(std::string_view text, ServerConfig& config) {
+        const auto colon_pos = text.find(':');
+
+        if (colon_pos == std::string_view::npos) {
+            return false;
+        }
+
+        const std::string group_text {text.substr(0, colon_pos)};
+        const auto port = parseCount(text.substr(colon_pos + 1));
+        in_addr group {};
+
+        if (inet_pton(AF_INET, group_text.c_str(), &group) != 1 or not IN_MULTICAST(ntohl(group.s_addr)) or port.value_or(0UL) == 0UL or port.value() > max_port) {
+            return false;
+        }
+
+        config.multicast_group = group.s_addr;
+        config.multicast_port = htons(static_cast<in_port_t>(port.value()));
+
+        return true;
+    }
+
+    std::optional<ServerConfig> parseConfig(int argc, char* argv[]) {
+        if (argc < 2) {
+            return {};
+        }
+
+        ServerConfig temp {
+            .port_cstr = argv[1],
+            .cache_bytes = default_cache_mb * bytes_per_mb,
+            .packet_cache_bytes = 0UL,
+            .prewarm_path = nullptr,
+            .prewarm_lock_bytes = 0UL,
+            .worker_count = 1UL,
+            .first_core = {},
+            .io_backend = IoBackend::epoll,
+            .max_sessions = default_max_sessions,
+            .pool_bytes = default_pool_mb * bytes_per_mb,
+            .huge_pages = false,
+            .write_behind_bytes = default_write_behind_mb * bytes_per_mb,
+            .metrics_path = nullptr,
+            .rate_bytes = 0UL,
+            .session_rate_bytes = 0UL,
+            .rate_classes = {},
+            .multicast_group = INADDR_ANY,
+            .multicast_port = 0,
+            .multicast_interface = INADDR_ANY
+        };
+
+        if (std::atoi(temp.port_cstr) <= min_free_port) {
+            return {};
+        }
+
+        for (auto arg_index = 2; arg_index < argc; arg_index += 2) {
+            const std::string_view flag {argv[arg_index]};
+
+            if (arg_index + 1 >= argc) {
+                return {};
+            }
+
+            const std::string_view value {argv[arg_index + 1]};
+
+            if (flag == "--cache-mb") {
+                const auto cache_mb = parseCount(value);
+
+                if (not cache_mb.has_value()) {
+                    return {};
+                }
+
+                temp.cache_bytes = cache_mb.value() * bytes_per_mb;
+            } else if (flag == "--packet-cache-mb") {
+                const auto packet_cache_mb = parseCount(value);
+
+                if (not packet_cache_mb.has_value()) {
+                    return {};
+                }
+
+                temp.packet_cache_bytes = packet_cache_mb.value() * bytes_per_mb;
+            } else if (flag == "--prewarm" and not value.empty()) {
+                temp.prewarm_path = argv[arg_index + 1];
+            } else if (flag == "--prewarm-lock-mb") {
+                const auto lock_mb = parseCount(value);
+
+                if (not lock_mb.has_value()) {
+                    return {};
+                }
+
+                temp.prewarm_lock_bytes = lock_mb.value() * bytes_per_mb;
+            } else if (flag == "--workers") {
+                const auto worker_count = parseCount(value);
+
+                if (not worker_count.has_value() or worker_count.value() == 0UL or worker_count.value() > max_worker_count) {
+                    return {};
+                }
+
+                temp.worker_count = worker_count.value();
+            } else if (flag == "--pin-cores") {
+                temp.first_core = parseCount(value);
+
+                if (not temp.first_core.has_value()) {
+                    return {};
+                }
+            } else if (flag == "--io-backend" and (value == "epoll" or value == "uring")) {
+                temp.io_backend = (value == "uring") ? IoBackend::uring : IoBackend::epoll;
+            } else if (flag == "--max-sessions") {
+                const auto max_sessions = parseCount(value);
+
+                if (not max_sessions.has_value() or max_sessions.value() == 0UL) {
+                    return {};
+                }
+
+                temp.max_sessions = max_sessions.value();
+            } else if (flag == "--pool-mb") {
+                const auto pool_mb = parseCount(value);
+
+                if (not pool_mb.has_value() or pool_mb.value() == 0UL) {
+                    return {};
+                }
+
+                temp.pool_bytes = pool_mb.value() * bytes_per_mb;
+            } else if (flag == "--huge-pages" and (value == "on" or value == "off")) {
+                temp.huge_pages = value == "on";
+            } else if (flag == "--write-behind-mb") {
+                const auto write_behind_mb = parseCount(value);
+
+                if (not write_behind_mb.has_value()) {
+                    return {};
+                }
+
+                temp.write_behind_bytes = write_behind_mb.value() * bytes_per_mb;
+            } else if (flag == "--metrics-file" and not value.empty()) {
+                temp.metrics_path = argv[arg_index + 1];
+            } else if (flag == "--rate-mbit" or flag == "--session-rate-mbit") {
+                const auto rate_mbit = parseCount(value);
+
+                if (not rate_mbit.has_value()) {
+                    return {};
+                }
+
+                auto& rate_bytes = (flag == "--rate-mbit") ? temp.rate_bytes : temp.session_rate_bytes;
+                rate_bytes = rate_mbit.value() * bytes_per_mbit;
+            } else if (flag == "--rate-class" and temp.rate_classes.size() < max_rate_classes) {
+                const auto rate_class = parseRateClass(value);
+
+                if (not rate_class.has_value()) {
+                    return {};
+                }
+
+                temp.rate_classes.push_back(rate_class.value());
+            } else if (flag == "--multicast") {
+                if (not parseMulticastGroup(value, temp)) {
+                    return {};
+                }
+            } else if (flag == "--multicast-if") {
+                const std::string interface_text {value};
+                in_addr interface_addr {};
+
+                if (inet_pton(AF_INET, interface_text.c_str(), &interface_addr) != 1) {
+                    return {};
+                }
+
+                temp.multicast_interface = interface_addr.s_addr;
+            } else {
+                return {};
+            }
+        }
+
+        /// NOTE: the groups of the last worker must still be multicast addresses.
+        if (const auto first_group = ntohl(temp.multicast_group); temp.multicast_group != INADDR_ANY and not IN_MULTICAST(first_group + temp.worker_count * multicast_groups_per_worker - 1UL)) {
+            return {};
+        }
+
+        return temp;
+    }
+}
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+#include "driver/filecache.hpp"
+
+namespace TftpServer::Driver {
+    static constexpr auto cache_chunk_size = 65536UL;
+
+    enum ChunkState : unsigned char {
+        chunk_empty,
+        chunk_filling,
+        chunk_ready
+    };
+
+    FileIdentity makeFileIdentity(const struct stat& status) noexcept {
+        return {
+            .device = status.st_dev,
+            .inode = status.st_ino,
+            .size = status.st_size,
+            .mtime_secs = static_cast<std::int64_t>(status.st_mtim.tv_sec),
+            .mtime_nsecs = static_cast<std::int64_t>(status.st_mtim.tv_nsec)
+        };
+    }
+
+    /// NOTE: `new[]` without a value-initializer leaves the pages untouched, so chunks nobody reads never become resident.
+    CachedFile::CachedFile(const FileIdentity& identity, FileCacheCounters& counters)
+    : m_data {new unsigned char[std::max(static_cast<std::size_t>(identity.size), 1UL)]}, m_chunk_states {}, m_counters {counters}, m_identity {identity}, m_chunk_count {(static_cast<std::size_t>(identity.size) + cache_chunk_size - 1UL) / cache_chunk_size}, m_locked {false} {
+        m_chunk_states = std::make_unique<std::atomic<unsigned char>[]>(std::max(m_chunk_count, 1UL));
+
+        for (auto chunk_index = 0UL; chunk_index < m_chunk_count; chunk_index++) {
+            m_chunk_states[chunk_index].store(chunk_empty, std::memory_order_relaxed);
+        }
+    }
+
+    CachedFile::~CachedFile() {
+        /// NOTE: small copies live on the heap, whose pages outlive them, so the lock must be dropped explicitly.
+        if (m_locked) {
+            munlock(m_data.get(), static_cast<std::size_t>(m_identity.size));
+        }
+    }
+
+    const FileIdentity& CachedFile::getIdentity() const noexcept {
+        return m_identity;
+    }
+
+    bool CachedFile::ensureChunk(std::size_t chunk_index, const FileHandle& source, bool& loaded_now) noexcept {
+        auto& state = m_chunk_states[chunk_index];
+        auto expected = static_cast<unsigned char>(chunk_empty);
+
+        if (state.load(std::memory_order_acquire) == chunk_ready) {
+            return true;
+        }
+
+        /// NOTE: only one session fills a chunk. The others read around it from disk instead of waiting.
+        if (not state.compare_exchange_strong(expected, chunk_filling, std::memory_order_acq_rel)) {
+            return false;
+        }
+
+        const auto chunk_offset = chunk_index * cache_chunk_size;
+        const auto chunk_length = std::min(cache_chunk_size, static_cast<std::size_t>(m_identity.size) - chunk_offset);
+
+        if (source.readAt(m_data.get() + chunk_offset, chunk_length, chunk_offset) != static_cast<long>(chunk_length)) {
+            state.store(chunk_empty, std::memory_order_release);
+            return false;
+        }
+
+        state.store(chunk_ready, std::memory_order_release);
+        loaded_now = true;
+
+        return true;
+    }
+
+    long CachedFile::readAt(unsigned char* target, std::size_t length, std::uint64_t offset, const FileHandle& source) noexcept {
+        const auto file_size = static_cast<std::uint64_t>(m_identity.size);
+
+        if (offset >= file_size) {
+            return 0L;
+        }
+
+        const auto wanted_n = static_cast<std::size_t>(std::min<std::uint64_t>(length, file_size - offset));
+        auto done_n = 0UL;
+        auto cached_n = 0UL;
+        auto hit = true;
+        auto loaded_now = false;
+
+        while (done_n < wanted_n) {
+            const auto cursor = offset + done_n;
+            const auto chunk_index = static_cast<std::size_t>(cursor / cache_chunk_size);
+            const auto chunk_end = (chunk_index + 1UL) * cache_chunk_size;
+            const auto part_n = std::min(wanted_n - done_n, static_cast<std::size_t>(chunk_end - cursor));
+
+            if (ensureChunk(chunk_index, source, loaded_now)) {
+                std::memcpy(target + done_n, m_data.get() + cursor, part_n);
+                cached_n += part_n;
+                hit = hit and not loaded_now;
+            } else if (source.readAt(target + done_n, part_n, cursor) != static_cast<long>(part_n)) {
+                return -1L;
+            } else {
+                hit = false;
+            }
+
+            done_n += part_n;
+        }
+
+        (hit ? m_counters.block_hits : m_counters.block_misses).fetch_add(1UL, std::memory_order_relaxed);
+        m_counters.bytes_served.fetch_add(cached_n, std::memory_order_relaxed);
+
+        return static_cast<long>(done_n);
+    }
+
+    bool CachedFile::prefetch(const FileHandle& source) noexcept {
+        auto all_ready = true;
+
+        for (auto chunk_index = 0UL; chunk_index < m_chunk_count; chunk_index++) {
+            auto loaded_now = false;
+
+            all_ready = ensureChunk(chunk_index, source, loaded_now) and all_ready;
+        }
+
+        return all_ready;
+    }
+
+    bool CachedFile::lockResident() noexcept {
+        if (not m_locked and m_identity.size > 0) {
+            m_locked = mlock(m_data.get(), static_cast<std::size_t>(m_identity.size)) == 0;
+        }
+
+        return m_locked;
+    }
+
+    FileCache::FileCache(std::size_t capacity)
+    : m_lru {}, m_index {}, m_counters {}, m_mutex {}, m_capacity {capacity}, m_used {0} {}
+
+    std::shared_ptr<CachedFile> FileCache::acquire(const std::string& path, const FileHandle& file) {
+        const auto file_status = file.getStatus();
+
+        if (m_capacity == 0UL or not file_status.has_value() or not S_ISREG(file_status->st_mode)) {
+            return {};
+        }
+
+        const auto identity = makeFileIdentity(file_status.value());
+        const auto file_size = static_cast<std::size_t>(identity.size);
+
+        if (file_size > m_capacity) {
+            return {};
+        }
+
+        std::lock_guard guard {m_mutex};
+
+        if (auto index_it = m_index.find(path); index_it != m_index.end()) {
+            auto entry_it = index_it->second;
+
+            if (entry_it->second->getIdentity() == identity) {
+                m_lru.splice(m_lru.begin(), m_lru, entry_it);
+                return entry_it->second;
+            }
+
+            /// NOTE: the file changed on disk, so the stale copy is dropped from the cache. Sessions still using it keep their reference.
+            m_used -= static_cast<std::size_t>(entry_it->second->getIdentity().size);
+            m_lru.erase(entry_it);
+            m_index.erase(index_it);
+        }
+
+        while (m_used + file_size > m_capacity and not m_lru.empty()) {
+            auto& [victim_path, victim] = m_lru.back();
+
+            m_used -= static_cast<std::size_t>(victim->getIdentity().size);
+            m_index.erase(victim_path);
+            m_lru.pop_back();
+            m_counters.evictions.fetch_add(1UL, std::memory_order_relaxed);
+        }
+
+        m_lru.emplace_front(path, std::make_shared<CachedFile>(identity, m_counters));
+        m_index[path] = m_lru.begin();
+        m_used += file_size;
+
+        return m_lru.front().second;
+    }
+
+    FileCacheStats FileCache::getStats() const {
+        std::lock_guard guard {m_mutex};
+
+        return {
+            .block_hits = m_counters.block_hits.load(std::memory_order_relaxed),
+            .block_misses = m_counters.block_misses.load(std::memory_order_relaxed),
+            .bytes_served = m_counters.bytes_served.load(std::memory_order_relaxed),
+            .bytes_resident = m_used,
+            .evictions = m_counters.evictions.load(std::memory_order_relaxed),
+            .files = m_lru.size()
+        };
+    }
+}
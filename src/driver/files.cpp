@@ -0,0 +1,135 @@
+#include <cerrno>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include "driver/files.hpp"
+
+namespace TftpServer::Driver {
+    static constexpr auto dud_file_fd = -1;
+
+    FileHandle::FileHandle() noexcept
+    : m_fd {dud_file_fd} {}
+
+    FileHandle::FileHandle(const std::string& path, FileAccess access) noexcept
+    : m_fd {(access == FileAccess::read) ? open(path.c_str(), O_RDONLY | O_CLOEXEC) : open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)} {}
+
+    FileHandle::~FileHandle() {
+        close();
+    }
+
+    FileHandle::FileHandle(FileHandle&& other) noexcept
+    : m_fd {std::exchange(other.m_fd, dud_file_fd)} {}
+
+    FileHandle& FileHandle::operator=(FileHandle&& other) noexcept {
+        if (&other == this) {
+            return *this;
+        }
+
+        close();
+        m_fd = std::exchange(other.m_fd, dud_file_fd);
+
+        return *this;
+    }
+
+    bool FileHandle::isOpen() const noexcept {
+        return m_fd != dud_file_fd;
+    }
+
+    int FileHandle::getFd() const noexcept {
+        return m_fd;
+    }
+
+    std::optional<struct stat> FileHandle::getStatus() const noexcept {
+        struct stat temp {};
+
+        if (not isOpen() or fstat(m_fd, &temp) != 0) {
+            return {};
+        }
+
+        return temp;
+    }
+
+    FileHandle FileHandle::duplicate() const noexcept {
+        FileHandle temp;
+
+        if (isOpen()) {
+            temp.m_fd = fcntl(m_fd, F_DUPFD_CLOEXEC, 0);
+        }
+
+        return temp;
+    }
+
+    long FileHandle::readAt(unsigned char* target, std::size_t length, std::uint64_t offset) const noexcept {
+        std::size_t done_n = 0;
+
+        /// NOTE: `pread` may come back short when interrupted, so only a zero return means end of file.
+        while (done_n < length) {
+            const auto read_n = pread(m_fd, target + done_n, length - done_n, static_cast<off_t>(offset + done_n));
+
+            if (read_n == 0) {
+                break;
+            } else if (read_n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                return -1L;
+            }
+
+            done_n += static_cast<std::size_t>(read_n);
+        }
+
+        return static_cast<long>(done_n);
+    }
+
+    bool FileHandle::writeAll(const unsigned char* source, std::size_t length) noexcept {
+        std::size_t done_n = 0;
+
+        while (done_n < length) {
+            const auto written_n = write(m_fd, source + done_n, length - done_n);
+
+            if (written_n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                return false;
+            }
+
+            done_n += static_cast<std::size_t>(written_n);
+        }
+
+        return true;
+    }
+
+    bool FileHandle::writeAt(const unsigned char* source, std::size_t length, std::uint64_t offset) const noexcept {
+        std::size_t done_n = 0;
+
+        while (done_n < length) {
+            const auto written_n = pwrite(m_fd, source + done_n, length - done_n, static_cast<off_t>(offset + done_n));
+
+            if (written_n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                return false;
+            }
+
+            done_n += static_cast<std::size_t>(written_n);
+        }
+
+        return true;
+    }
+
+    bool FileHandle::sync() const noexcept {
+        return fdatasync(m_fd) == 0;
+    }
+
+    void FileHandle::close() noexcept {
+        if (m_fd != dud_file_fd) {
+            ::close(m_fd);
+            m_fd = dud_file_fd;
+        }
+    }
+}
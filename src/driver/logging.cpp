@@ -0,0 +1,209 @@
+#include <array>
+#include <cerrno>
+#include <iterator>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "driver/logging.hpp"
+
+namespace TftpServer::Driver {
+    static std::atomic<AsyncLogger*> active_logger {nullptr};
+
+    static constexpr std::array<const char*, 4> log_level_names = {
+        "DEBUG",
+        "INFO",
+        "WARN",
+        "ERROR"
+    };
+
+    [[nodiscard]] static bool writeAllTo(int fd, const std::string& lines) noexcept {
+        std::size_t done_n = 0;
+
+        while (done_n < lines.size()) {
+            const auto written_n = write(fd, lines.data() + done_n, lines.size() - done_n);
+
+            if (written_n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                return false;
+            }
+
+            done_n += static_cast<std::size_t>(written_n);
+        }
+
+        return true;
+    }
+
+    LogOrigin makeLogOrigin(unsigned int worker, unsigned int session, const sockaddr_in& peer) noexcept {
+        return {worker, session, peer.sin_addr.s_addr, peer.sin_port};
+    }
+
+    void appendLogLine(std::string& lines, const LogRecord& record) {
+        const auto& [worker, session, peer_ip, peer_port] = record.origin;
+        auto line_it = std::back_inserter(lines);
+
+        line_it = std::format_to(line_it, "tftpd [{}] {:%FT%T}Z", log_level_names[static_cast<std::size_t>(record.level)], std::chrono::floor<std::chrono::microseconds>(record.stamp));
+
+        if (worker != log_no_worker) {
+            line_it = std::format_to(line_it, " worker={}", worker);
+        }
+
+        if (session != 0U) {
+            line_it = std::format_to(line_it, " session={}", session);
+        }
+
+        if (peer_port != 0U) {
+            std::array<char, INET_ADDRSTRLEN> ip_text {};
+            in_addr peer_addr {peer_ip};
+
+            inet_ntop(AF_INET, &peer_addr, ip_text.data(), ip_text.size());
+            line_it = std::format_to(line_it, " peer={}:{}", ip_text.data(), ntohs(peer_port));
+        }
+
+        lines += ": ";
+        lines.append(record.text, record.text_length);
+        lines += '\n';
+    }
+
+    void writeLogNow(const LogRecord& record) noexcept {
+        try {
+            std::string line;
+
+            appendLogLine(line, record);
+            static_cast<void>(writeAllTo(STDOUT_FILENO, line));
+        } catch (...) {}
+    }
+
+    void setActiveLogger(AsyncLogger* logger) noexcept {
+        active_logger.store(logger, std::memory_order_release);
+    }
+
+    AsyncLogger* getActiveLogger() noexcept {
+        return active_logger.load(std::memory_order_acquire);
+    }
+
+    AsyncLogger::AsyncLogger(int fd)
+    : m_cells {std::make_unique<Cell[]>(log_ring_capacity)}, m_enqueue_pos {0}, m_dequeue_pos {0}, m_dropped {0}, m_idle {false}, m_fd {fd}, m_thread {} {
+        /// NOTE: a cell is free for the producer at position `p` once its sequence reads `p`, and ready for the drain thread once it reads `p + 1`.
+        for (auto cell_index = 0UL; cell_index < log_ring_capacity; cell_index++) {
+            m_cells[cell_index].sequence.store(cell_index, std::memory_order_relaxed);
+        }
+
+        m_thread = std::jthread {[this](std::stop_token stop_token) {
+            runDrain(stop_token);
+        }};
+    }
+
+    AsyncLogger::~AsyncLogger() {
+        if (getActiveLogger() == this) {
+            setActiveLogger(nullptr);
+        }
+
+        m_thread.request_stop();
+        wakeDrain();
+
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    AsyncLogger::Cell* AsyncLogger::claimCell() noexcept {
+        auto position = m_enqueue_pos.load(std::memory_order_relaxed);
+
+        /// NOTE: bounded MPMC queue after Dmitry Vyukov, where producers race for a position with one CAS and never wait on each other.
+        while (true) {
+            auto* cell = &m_cells[position & (log_ring_capacity - 1UL)];
+            const auto sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto lag = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+            if (lag == 0) {
+                if (m_enqueue_pos.compare_exchange_weak(position, position + 1UL, std::memory_order_relaxed)) {
+                    return cell;
+                }
+            } else if (lag < 0) {
+                m_dropped.fetch_add(1UL, std::memory_order_relaxed);
+                return nullptr;
+            } else {
+                position = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void AsyncLogger::publishCell(Cell* cell) noexcept {
+        const auto position = cell->sequence.load(std::memory_order_relaxed);
+
+        cell->sequence.store(position + 1UL, std::memory_order_release);
+        wakeDrain();
+    }
+
+    void AsyncLogger::wakeDrain() noexcept {
+        /// NOTE: pairs with the fence in `runDrain`, so either the drain thread sees the new record or this sees it going idle. Only that transition costs a wakeup.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (m_idle.load(std::memory_order_relaxed) and m_idle.exchange(false, std::memory_order_relaxed)) {
+            m_idle.notify_one();
+        }
+    }
+
+    bool AsyncLogger::hasReadyCell() const noexcept {
+        const auto& cell = m_cells[m_dequeue_pos & (log_ring_capacity - 1UL)];
+
+        return cell.sequence.load(std::memory_order_acquire) == m_dequeue_pos + 1UL;
+    }
+
+    std::size_t AsyncLogger::drainBatch(std::string& lines) {
+        auto drained_n = 0UL;
+
+        while (hasReadyCell()) {
+            auto& cell = m_cells[m_dequeue_pos & (log_ring_capacity - 1UL)];
+
+            appendLogLine(lines, cell.record);
+            cell.sequence.store(m_dequeue_pos + log_ring_capacity, std::memory_order_release);
+            m_dequeue_pos++;
+            drained_n++;
+        }
+
+        return drained_n;
+    }
+
+    void AsyncLogger::runDrain(std::stop_token stop_token) {
+        std::string lines;
+        auto reported_drops = 0UL;
+
+        /// NOTE: the ring gets emptied once more after a stop, so records pushed during shutdown still show up.
+        while (true) {
+            const auto stopping = stop_token.stop_requested();
+            const auto drained_n = drainBatch(lines);
+
+            if (const auto dropped_n = m_dropped.load(std::memory_order_relaxed); dropped_n != reported_drops) {
+                std::format_to(std::back_inserter(lines), "tftpd [WARN]: logger dropped {} records while its ring was full\n", dropped_n - reported_drops);
+                reported_drops = dropped_n;
+            }
+
+            if (not lines.empty()) {
+                static_cast<void>(writeAllTo(m_fd, lines));
+                lines.clear();
+            }
+
+            if (stopping) {
+                break;
+            }
+
+            if (drained_n > 0UL) {
+                continue;
+            }
+
+            /// NOTE: an idle drain thread blocks until a producer publishes into the empty ring or a stop comes, so an idle server never wakes it.
+            m_idle.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (hasReadyCell() or stop_token.stop_requested()) {
+                m_idle.store(false, std::memory_order_relaxed);
+                continue;
+            }
+
+            m_idle.wait(true, std::memory_order_relaxed);
+        }
+    }
+}
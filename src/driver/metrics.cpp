@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cstdio>
+#include <format>
+#include <iterator>
+#include "driver/filecache.hpp"
+#include "driver/logging.hpp"
+#include "driver/metrics.hpp"
+#include "driver/packetcache.hpp"
+
+namespace TftpServer::Driver {
+    static constexpr auto metrics_export_period = std::chrono::seconds {1};
+    static constexpr auto nanos_per_second = 1e9;
+
+    [[nodiscard]] static std::uint64_t readCounter(const MetricCounter& counter) noexcept {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+    static void renderHeader(std::string& out, std::string_view name, std::string_view type, std::string_view help) {
+        std::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+    }
+
+    LatencyHistogram::LatencyHistogram(std::span<const std::uint64_t> bounds_ns) noexcept
+    : m_bounds_ns {bounds_ns.first(std::min(bounds_ns.size(), max_histogram_buckets))}, m_buckets {}, m_sum_ns {0}, m_count {0} {}
+
+    void LatencyHistogram::record(std::chrono::nanoseconds value) noexcept {
+        const auto value_ns = static_cast<std::uint64_t>(std::max(value.count(), std::chrono::nanoseconds::rep {0}));
+        const auto bucket_index = static_cast<std::size_t>(std::ranges::lower_bound(m_bounds_ns, value_ns) - m_bounds_ns.begin());
+
+        bumpCounter(m_buckets[bucket_index]);
+        bumpCounter(m_sum_ns, value_ns);
+        bumpCounter(m_count);
+    }
+
+    void LatencyHistogram::render(std::string& out, std::string_view name, std::string_view labels) const {
+        const auto separator = labels.empty() ? "" : ",";
+        auto out_it = std::back_inserter(out);
+        auto cumulative_n = 0UL;
+
+        for (auto bucket_index = 0UL; bucket_index < m_bounds_ns.size(); bucket_index++) {
+            cumulative_n += readCounter(m_buckets[bucket_index]);
+            out_it = std::format_to(out_it, "{}_bucket{{{}{}le=\"{}\"}} {}\n", name, labels, separator, static_cast<double>(m_bounds_ns[bucket_index]) / nanos_per_second, cumulative_n);
+        }
+
+        cumulative_n += readCounter(m_buckets[m_bounds_ns.size()]);
+        out_it = std::format_to(out_it, "{}_bucket{{{}{}le=\"+Inf\"}} {}\n", name, labels, separator, cumulative_n);
+        out_it = std::format_to(out_it, "{}_sum{{{}}} {}\n", name, labels, static_cast<double>(readCounter(m_sum_ns)) / nanos_per_second);
+        std::format_to(out_it, "{}_count{{{}}} {}\n", name, labels, readCounter(m_count));
+    }
+
+    WorkerMetrics::WorkerMetrics() noexcept
+    : packets_in {0}, packets_out {0}, data_bytes_out {0}, data_bytes_in {0}, retransmits {0}, active_sessions {0}, errors_sent {}, ack_rtt {ack_rtt_bounds_ns}, rrq_durations {transfer_duration_bounds_ns}, wrq_durations {transfer_duration_bounds_ns} {}
+
+    MetricsRegistry::MetricsRegistry(std::size_t worker_count, const FileCache* file_cache, const PacketCache* packet_cache)
+    : m_workers {}, m_file_cache {file_cache}, m_packet_cache {packet_cache} {
+        m_workers.reserve(worker_count);
+
+        for (auto worker_index = 0UL; worker_index < worker_count; worker_index++) {
+            m_workers.emplace_back(std::make_unique<WorkerMetrics>());
+        }
+    }
+
+    WorkerMetrics& MetricsRegistry::getWorker(std::size_t worker_index) noexcept {
+        return *m_workers[worker_index];
+    }
+
+    void MetricsRegistry::renderCaches(std::string& out) const {
+        struct CacheSeries {
+            std::string_view name;
+            std::string_view type;
+            std::string_view help;
+            std::uint64_t value;
+        };
+
+        auto render_series = [&out](std::span<const CacheSeries> series) {
+            for (const auto& [name, type, help, value] : series) {
+                renderHeader(out, name, type, help);
+                std::format_to(std::back_inserter(out), "{} {}\n", name, value);
+            }
+        };
+
+        /// NOTE: each cache takes its lock once per render, so a scrape never holds it across formatting.
+        if (m_file_cache != nullptr) {
+            const auto [block_hits, block_misses, bytes_served, bytes_resident, evictions, files] = m_file_cache->getStats();
+            const std::array<CacheSeries, 6> series {{
+                {"tftpd_file_cache_hits_total", "counter", "Blocks copied from file cache chunks already loaded.", block_hits},
+                {"tftpd_file_cache_misses_total", "counter", "Blocks which needed disk reads to fill the file cache.", block_misses},
+                {"tftpd_file_cache_served_bytes_total", "counter", "DATA payload octets copied out of the file cache.", bytes_served},
+                {"tftpd_file_cache_resident_bytes", "gauge", "Octets reserved by files in the file cache.", bytes_resident},
+                {"tftpd_file_cache_evictions_total", "counter", "Files evicted from the file cache to make room.", evictions},
+                {"tftpd_file_cache_files", "gauge", "Files held by the file cache.", files}
+            }};
+
+            render_series(series);
+        }
+
+        if (m_packet_cache != nullptr) {
+            const auto [hits, misses, builds, bytes_resident, evictions, files] = m_packet_cache->getStats();
+            const std::array<CacheSeries, 6> series {{
+                {"tftpd_packet_cache_hits_total", "counter", "Transfers served from DATA messages already encoded.", hits},
+                {"tftpd_packet_cache_misses_total", "counter", "Transfers of cacheable files which read through the normal path.", misses},
+                {"tftpd_packet_cache_builds_total", "counter", "Files encoded by the packet cache's builder after a miss.", builds},
+                {"tftpd_packet_cache_resident_bytes", "gauge", "Octets of encoded DATA messages held by the packet cache.", bytes_resident},
+                {"tftpd_packet_cache_evictions_total", "counter", "Files evicted from the packet cache to make room.", evictions},
+                {"tftpd_packet_cache_files", "gauge", "Files held by the packet cache.", files}
+            }};
+
+            render_series(series);
+        }
+    }
+
+    std::string MetricsRegistry::render() const {
+        struct CounterFamily {
+            std::string_view name;
+            std::string_view type;
+            std::string_view help;
+            MetricCounter WorkerMetrics::* counter;
+        };
+
+        static constexpr std::array<CounterFamily, 6> counter_families {{
+            {"tftpd_packets_received_total", "counter", "Datagrams received by listeners and sessions.", &WorkerMetrics::packets_in},
+            {"tftpd_packets_sent_total", "counter", "Datagrams sent by listeners and sessions.", &WorkerMetrics::packets_out},
+            {"tftpd_data_bytes_sent_total", "counter", "DATA payload octets sent for reads, re-sends included.", &WorkerMetrics::data_bytes_out},
+            {"tftpd_data_bytes_received_total", "counter", "DATA payload octets stored for writes.", &WorkerMetrics::data_bytes_in},
+            {"tftpd_retransmits_total", "counter", "Replies or windows sent again after a timeout or a repeated request.", &WorkerMetrics::retransmits},
+            {"tftpd_active_sessions", "gauge", "Transfers in progress.", &WorkerMetrics::active_sessions}
+        }};
+
+        std::string out;
+        auto out_it = std::back_inserter(out);
+
+        for (const auto& [name, type, help, counter] : counter_families) {
+            renderHeader(out, name, type, help);
+
+            for (auto worker_index = 0UL; worker_index < m_workers.size(); worker_index++) {
+                out_it = std::format_to(out_it, "{}{{worker=\"{}\"}} {}\n", name, worker_index, readCounter((*m_workers[worker_index]).*counter));
+            }
+        }
+
+        renderHeader(out, "tftpd_errors_sent_total", "counter", "ERROR messages sent, by TFTP error code.");
+
+        for (auto worker_index = 0UL; worker_index < m_workers.size(); worker_index++) {
+            const auto& errors_sent = m_workers[worker_index]->errors_sent;
+
+            for (auto error_code = 0UL; error_code < errors_sent.size(); error_code++) {
+                out_it = std::format_to(out_it, "tftpd_errors_sent_total{{worker=\"{}\",code=\"{}\"}} {}\n", worker_index, error_code, readCounter(errors_sent[error_code]));
+            }
+        }
+
+        renderHeader(out, "tftpd_ack_rtt_seconds", "histogram", "Round trip from a reply sent once to the peer's answer, per Karn's rule.");
+
+        for (auto worker_index = 0UL; worker_index < m_workers.size(); worker_index++) {
+            m_workers[worker_index]->ack_rtt.render(out, "tftpd_ack_rtt_seconds", std::format("worker=\"{}\"", worker_index));
+        }
+
+        renderHeader(out, "tftpd_transfer_duration_seconds", "histogram", "Time from a request until its session ended, failed transfers included.");
+
+        for (auto worker_index = 0UL; worker_index < m_workers.size(); worker_index++) {
+            m_workers[worker_index]->rrq_durations.render(out, "tftpd_transfer_duration_seconds", std::format("worker=\"{}\",op=\"rrq\"", worker_index));
+            m_workers[worker_index]->wrq_durations.render(out, "tftpd_transfer_duration_seconds", std::format("worker=\"{}\",op=\"wrq\"", worker_index));
+        }
+
+        renderCaches(out);
+
+        return out;
+    }
+
+    MetricsExporter::MetricsExporter(std::string path, const MetricsRegistry& registry)
+    : m_path {std::move(path)}, m_temp_path {}, m_registry {registry}, m_mutex {}, m_wakeup {}, m_thread {} {
+        m_temp_path = m_path + ".tmp";
+        m_thread = std::jthread {[this](std::stop_token stop_token) {
+            runExport(stop_token);
+        }};
+    }
+
+    bool MetricsExporter::writeOnce() const {
+        const auto text = m_registry.render();
+        auto* temp_file = std::fopen(m_temp_path.c_str(), "w");
+
+        if (temp_file == nullptr) {
+            return false;
+        }
+
+        const auto written_ok = std::fwrite(text.data(), 1UL, text.size(), temp_file) == text.size();
+
+        if (std::fclose(temp_file) != 0 or not written_ok) {
+            return false;
+        }
+
+        return std::rename(m_temp_path.c_str(), m_path.c_str()) == 0;
+    }
+
+    void MetricsExporter::runExport(std::stop_token stop_token) {
+        auto reported_failure = false;
+
+        /// NOTE: one last write on stop leaves the final totals behind.
+        while (true) {
+            const auto stopping = stop_token.stop_requested();
+
+            if (not writeOnce() and not reported_failure) {
+                logEvent<LogLevel::warn>({log_no_worker, 0U, 0, 0}, "could not write metrics to {}", m_path);
+                reported_failure = true;
+            }
+
+            if (stopping) {
+                break;
+            }
+
+            std::unique_lock lock {m_mutex};
+            m_wakeup.wait_for(lock, stop_token, metrics_export_period, [] {
+                return false;
+            });
+        }
+    }
+}
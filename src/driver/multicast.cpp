@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include "mytftp/options.hpp"
+#include "driver/session.hpp"
+#include "driver/multicast.hpp"
+
+namespace TftpServer::Driver {
+    MulticastRegistry::MulticastRegistry(const ServerConfig& config, unsigned int worker_id)
+    : m_transfers {}, m_leased {}, m_first_group {ntohl(config.multicast_group) + worker_id * static_cast<in_addr_t>(multicast_groups_per_worker)}, m_port {config.multicast_port}, m_interface {config.multicast_interface} {
+        if (config.multicast_group != INADDR_ANY) {
+            m_leased.resize(multicast_groups_per_worker, false);
+        }
+    }
+
+    bool MulticastRegistry::isEnabled() const noexcept {
+        return not m_leased.empty();
+    }
+
+    in_addr_t MulticastRegistry::getInterface() const noexcept {
+        return m_interface;
+    }
+
+    Session* MulticastRegistry::findTransfer(const MyTftp::RWPayload& request) const {
+        const auto& [filename, mode, options] = request;
+        const auto wants_multicast = std::ranges::any_of(options, [](const MyTftp::OptionEntry& entry) {
+            return entry.name == MyTftp::option_name_multicast;
+        });
+
+        if (not wants_multicast or mode != MyTftp::DataMode::octet) {
+            return nullptr;
+        }
+
+        const auto transfer_it = m_transfers.find(filename);
+
+        if (transfer_it == m_transfers.end() or transfer_it->second->isDone()) {
+            return nullptr;
+        }
+
+        return transfer_it->second;
+    }
+
+    std::optional<MulticastGroup> MulticastRegistry::lease(const std::string& filename, Session& session) {
+        const auto free_it = std::ranges::find(m_leased, false);
+
+        if (free_it == m_leased.end()) {
+            return {};
+        }
+
+        /// NOTE: a finished transfer stays registered until its worker reaps it, and a new one for the file may take over its entry meanwhile.
+        if (const auto transfer_it = m_transfers.find(filename); transfer_it != m_transfers.end() and not transfer_it->second->isDone()) {
+            return {};
+        }
+
+        const auto slot = static_cast<std::size_t>(free_it - m_leased.begin());
+        sockaddr_in group_address {};
+
+        group_address.sin_family = AF_INET;
+        group_address.sin_port = m_port;
+        group_address.sin_addr.s_addr = htonl(m_first_group + static_cast<in_addr_t>(slot));
+
+        *free_it = true;
+        m_transfers.insert_or_assign(filename, &session);
+
+        return MulticastGroup {group_address, slot};
+    }
+
+    void MulticastRegistry::release(const MulticastGroup& group, const Session& session) noexcept {
+        m_leased[group.slot] = false;
+
+        std::erase_if(m_transfers, [&session](const auto& entry) {
+            return entry.second == &session;
+        });
+    }
+}
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <utility>
+#include "mytftp/messaging.hpp"
+#include "driver/packetcache.hpp"
+
+namespace TftpServer::Driver {
+    [[nodiscard]] static std::string makePacketKey(const std::string& path, std::size_t block_size) {
+        /// NOTE: a NUL never occurs in a request's filename, so it cleanly separates the block size.
+        auto temp = path;
+
+        temp.push_back('\0');
+        temp.append(std::to_string(block_size));
+
+        return temp;
+    }
+
+    EncodedFile::EncodedFile(const FileIdentity& identity, std::size_t block_size)
+    : m_packets {}, m_identity {identity}, m_block_size {block_size}, m_block_count {static_cast<std::uint64_t>(identity.size) / block_size + 1U} {
+        m_packets = std::make_unique_for_overwrite<unsigned char[]>(getEncodedSize());
+    }
+
+    bool EncodedFile::encode(const FileHandle& source) noexcept {
+        const auto packet_stride = MyTftp::data_header_size + m_block_size;
+        const auto file_size = static_cast<std::uint64_t>(m_identity.size);
+
+        for (auto block_index = 1UL; block_index <= m_block_count; block_index++) {
+            auto* packet_ptr = m_packets.get() + (block_index - 1UL) * packet_stride;
+            MyBSock::SpanBuffer<MyTftp::tftp_u8> header {packet_ptr, MyTftp::data_header_size};
+            const auto chunk_offset = (block_index - 1UL) * m_block_size;
+            const auto chunk_length = std::min<std::uint64_t>(m_block_size, file_size - chunk_offset);
+
+            if (not MyTftp::serializeDataHeader(header, static_cast<MyTftp::tftp_u16>(block_index))) {
+                return false;
+            }
+
+            /// NOTE: a file changing while read shows up as a short read, and its copy then never gets served.
+            if (chunk_length > 0U and source.readAt(packet_ptr + MyTftp::data_header_size, chunk_length, chunk_offset) != static_cast<long>(chunk_length)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    const FileIdentity& EncodedFile::getIdentity() const noexcept {
+        return m_identity;
+    }
+
+    std::size_t EncodedFile::getBlockSize() const noexcept {
+        return m_block_size;
+    }
+
+    std::uint64_t EncodedFile::getBlockCount() const noexcept {
+        return m_block_count;
+    }
+
+    std::size_t EncodedFile::getEncodedSize() const noexcept {
+        return static_cast<std::size_t>(m_block_count) * MyTftp::data_header_size + static_cast<std::size_t>(m_identity.size);
+    }
+
+    std::span<const unsigned char> EncodedFile::getPacket(std::uint64_t block_index) const noexcept {
+        const auto packet_stride = MyTftp::data_header_size + m_block_size;
+        const auto chunk_offset = (block_index - 1U) * m_block_size;
+        const auto chunk_length = std::min<std::uint64_t>(m_block_size, static_cast<std::uint64_t>(m_identity.size) - chunk_offset);
+
+        return {m_packets.get() + (block_index - 1U) * packet_stride, MyTftp::data_header_size + static_cast<std::size_t>(chunk_length)};
+    }
+
+    PacketCache::PacketCache(std::size_t capacity)
+    : m_lru {}, m_index {}, m_tasks {}, m_queued_keys {}, m_hits {0UL}, m_misses {0UL}, m_builds {0UL}, m_evictions {0UL}, m_mutex {}, m_wakeup {}, m_capacity {capacity}, m_used {0}, m_thread {} {
+        m_thread = std::jthread {[this](std::stop_token stop_token) {
+            runBuilder(stop_token);
+        }};
+    }
+
+    void PacketCache::runBuilder(std::stop_token stop_token) {
+        std::unique_lock lock {m_mutex};
+
+        /// NOTE: unlike uploads, queued builds are only an optimization, so a stop drops them.
+        while (true) {
+            m_wakeup.wait(lock, stop_token, [this] {
+                return not m_tasks.empty();
+            });
+
+            if (stop_token.stop_requested()) {
+                break;
+            }
+
+            auto task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+
+            lock.unlock();
+            runTask(task);
+            lock.lock();
+        }
+    }
+
+    void PacketCache::runTask(BuildTask& task) {
+        std::shared_ptr<EncodedFile> encoded;
+
+        try {
+            encoded = std::make_shared<EncodedFile>(task.identity, task.block_size);
+        } catch (...) {}
+
+        /// NOTE: the file may have changed since the request, so the copy only counts when its identity still matches afterwards.
+        const auto built = encoded != nullptr and encoded->getEncodedSize() <= m_capacity and encoded->encode(task.file) and [&task] {
+            const auto file_status = task.file.getStatus();
+
+            return file_status.has_value() and makeFileIdentity(file_status.value()) == task.identity;
+        }();
+
+        task.file.close();
+
+        std::lock_guard guard {m_mutex};
+
+        m_queued_keys.erase(task.key);
+
+        if (not built) {
+            return;
+        }
+
+        m_builds.fetch_add(1UL, std::memory_order_relaxed);
+
+        /// NOTE: any entry still under the key gets replaced, so its octets never count twice.
+        if (auto index_it = m_index.find(task.key); index_it != m_index.end()) {
+            m_used -= index_it->second->second->getEncodedSize();
+            m_lru.erase(index_it->second);
+            m_index.erase(index_it);
+        }
+
+        insert(task.key, std::move(encoded));
+    }
+
+    void PacketCache::insert(const std::string& key, std::shared_ptr<const EncodedFile> encoded) {
+        const auto encoded_size = encoded->getEncodedSize();
+
+        while (m_used + encoded_size > m_capacity and not m_lru.empty()) {
+            auto& [victim_key, victim] = m_lru.back();
+
+            m_used -= victim->getEncodedSize();
+            m_index.erase(victim_key);
+            m_lru.pop_back();
+            m_evictions.fetch_add(1UL, std::memory_order_relaxed);
+        }
+
+        m_lru.emplace_front(key, std::move(encoded));
+        m_index[key] = m_lru.begin();
+        m_used += encoded_size;
+    }
+
+    std::shared_ptr<const EncodedFile> PacketCache::acquire(const std::string& path, const FileHandle& file, std::size_t block_size) {
+        const auto file_status = file.getStatus();
+
+        if (m_capacity == 0UL or not file_status.has_value() or not S_ISREG(file_status->st_mode) or static_cast<std::size_t>(file_status->st_size) > packet_cache_max_file) {
+            return {};
+        }
+
+        const auto identity = makeFileIdentity(file_status.value());
+        auto key = makePacketKey(path, block_size);
+
+        std::lock_guard guard {m_mutex};
+
+        if (auto index_it = m_index.find(key); index_it != m_index.end()) {
+            auto entry_it = index_it->second;
+
+            if (entry_it->second->getIdentity() == identity) {
+                m_lru.splice(m_lru.begin(), m_lru, entry_it);
+                m_hits.fetch_add(1UL, std::memory_order_relaxed);
+                return entry_it->second;
+            }
+
+            /// NOTE: the file changed on disk, so the stale packets are dropped. Sessions still sending them keep their reference.
+            m_used -= entry_it->second->getEncodedSize();
+            m_lru.erase(entry_it);
+            m_index.erase(index_it);
+        }
+
+        m_misses.fetch_add(1UL, std::memory_order_relaxed);
+
+        if (m_tasks.size() < packet_cache_max_queued and not m_queued_keys.contains(key)) {
+            if (auto source = file.duplicate(); source.isOpen()) {
+                m_queued_keys.insert(key);
+                m_tasks.push_back({std::move(key), std::move(source), identity, block_size});
+                m_wakeup.notify_one();
+            }
+        }
+
+        return {};
+    }
+
+    PacketCacheStats PacketCache::getStats() const {
+        std::lock_guard guard {m_mutex};
+
+        return {
+            .hits = m_hits.load(std::memory_order_relaxed),
+            .misses = m_misses.load(std::memory_order_relaxed),
+            .builds = m_builds.load(std::memory_order_relaxed),
+            .bytes_resident = m_used,
+            .evictions = m_evictions.load(std::memory_order_relaxed),
+            .files = m_lru.size()
+        };
+    }
+}
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <fcntl.h>
+#include <glob.h>
+#include "driver/files.hpp"
+#include "driver/prewarm.hpp"
+
+namespace TftpServer::Driver {
+    /// NOTE: files beyond the cache still get read through once, this much at a time, so their pages are resident for the first requests.
+    static constexpr auto page_warm_chunk = 256UL * 1024UL;
+
+    struct PrewarmTarget {
+        std::string path;
+        bool cache;  // fits the shared cache's cap after the files before it
+        bool lock;   // fits the lock budget after the files before it
+    };
+
+    /// NOTE: absolute patterns and `..` could reach outside the served directory, which requests never can, so such lines get ignored.
+    [[nodiscard]] static bool isServedPattern(std::string_view pattern) noexcept {
+        return not pattern.empty() and pattern.front() != '/' and pattern != ".." and not pattern.starts_with("../") and pattern.find("/../") == std::string_view::npos and not pattern.ends_with("/..");
+    }
+
+    [[nodiscard]] static std::optional<std::vector<std::string>> readManifest(const char* manifest_path) {
+        std::ifstream manifest {manifest_path};
+
+        if (not manifest.is_open()) {
+            return {};
+        }
+
+        std::vector<std::string> temp;
+        std::unordered_set<std::string> seen;
+
+        for (std::string line; std::getline(manifest, line);) {
+            const auto first = line.find_first_not_of(" \t\r");
+            const auto last = line.find_last_not_of(" \t\r");
+
+            if (first == std::string::npos or line[first] == '#' or not isServedPattern(std::string_view {line}.substr(first, last - first + 1))) {
+                continue;
+            }
+
+            const auto pattern = line.substr(first, last - first + 1);
+            glob_t matches {};
+
+            /// NOTE: a plain path matches itself, and a glob matching nothing warms nothing.
+            if (glob(pattern.c_str(), GLOB_NOSORT, nullptr, &matches) == 0) {
+                for (auto match_index = 0UL; match_index < matches.gl_pathc; match_index++) {
+                    if (std::string match_path {matches.gl_pathv[match_index]}; seen.insert(match_path).second) {
+                        temp.push_back(std::move(match_path));
+                    }
+                }
+            }
+
+            globfree(&matches);
+        }
+
+        return temp;
+    }
+
+    [[nodiscard]] static std::uint64_t warmPageCache(const FileHandle& file, std::uint64_t file_size) {
+        auto chunk = std::make_unique_for_overwrite<unsigned char[]>(page_warm_chunk);
+        auto offset = 0UL;
+
+        while (offset < file_size) {
+            const auto read_n = file.readAt(chunk.get(), page_warm_chunk, offset);
+
+            if (read_n <= 0) {
+                break;
+            }
+
+            offset += static_cast<std::uint64_t>(read_n);
+        }
+
+        return offset;
+    }
+
+    std::optional<PrewarmReport> prewarmFiles(const char* manifest_path, FileCache& cache, std::size_t cache_bytes, std::size_t lock_bytes) {
+        const auto started_at = std::chrono::steady_clock::now();
+        const auto paths = readManifest(manifest_path);
+
+        if (not paths.has_value()) {
+            return {};
+        }
+
+        /// NOTE: budgets get handed out up front in manifest order, so the hottest files win no matter which thread loads them first.
+        std::vector<PrewarmTarget> targets;
+        auto cache_left = cache_bytes;
+        auto lock_left = lock_bytes;
+
+        for (const auto& path : paths.value()) {
+            struct stat status {};
+
+            if (stat(path.c_str(), &status) != 0 or not S_ISREG(status.st_mode)) {
+                continue;
+            }
+
+            const auto file_size = static_cast<std::size_t>(status.st_size);
+            const auto cache_it = file_size <= cache_left;
+            const auto lock_it = cache_it and file_size <= lock_left;
+
+            cache_left -= cache_it ? file_size : 0UL;
+            lock_left -= lock_it ? file_size : 0UL;
+            targets.push_back({path, cache_it, lock_it});
+        }
+
+        std::atomic<std::size_t> next_target {0UL};
+        std::atomic<std::size_t> cached_n {0UL};
+        std::atomic<std::size_t> locked_n {0UL};
+        std::atomic<std::size_t> failed_n {0UL};
+        std::atomic<std::uint64_t> read_bytes {0UL};
+        std::atomic<std::uint64_t> locked_bytes {0UL};
+
+        {
+            std::vector<std::jthread> threads;
+            const auto thread_count = std::min(prewarm_thread_count, targets.size());
+
+            for (auto thread_index = 0UL; thread_index < thread_count; thread_index++) {
+                threads.emplace_back([&] {
+                    for (auto target_index = next_target.fetch_add(1UL); target_index < targets.size(); target_index = next_target.fetch_add(1UL)) {
+                        const auto& [path, cache_it, lock_it] = targets[target_index];
+                        FileHandle file {path};
+                        const auto file_status = file.getStatus();
+
+                        if (not file_status.has_value()) {
+                            failed_n.fetch_add(1UL, std::memory_order_relaxed);
+                            continue;
+                        }
+
+                        const auto file_size = static_cast<std::uint64_t>(file_status->st_size);
+                        posix_fadvise(file.getFd(), 0, 0, POSIX_FADV_WILLNEED);
+
+                        if (auto cached = cache_it ? cache.acquire(path, file) : nullptr; cached != nullptr and cached->prefetch(file)) {
+                            cached_n.fetch_add(1UL, std::memory_order_relaxed);
+                            read_bytes.fetch_add(file_size, std::memory_order_relaxed);
+
+                            if (lock_it and cached->lockResident()) {
+                                locked_n.fetch_add(1UL, std::memory_order_relaxed);
+                                locked_bytes.fetch_add(file_size, std::memory_order_relaxed);
+                            }
+                        } else if (const auto warmed_n = warmPageCache(file, file_size); warmed_n == file_size) {
+                            read_bytes.fetch_add(warmed_n, std::memory_order_relaxed);
+                        } else {
+                            failed_n.fetch_add(1UL, std::memory_order_relaxed);
+                        }
+                    }
+                });
+            }
+        }
+
+        return PrewarmReport {
+            .files = targets.size(),
+            .cached_files = cached_n.load(),
+            .locked_files = locked_n.load(),
+            .failed_files = failed_n.load(),
+            .bytes_read = read_bytes.load(),
+            .bytes_locked = locked_bytes.load(),
+            .elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started_at)
+        };
+    }
+}
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include "driver/rto.hpp"
+
+namespace TftpServer::Driver {
+    RetransmitTimer::RetransmitTimer() noexcept
+    : m_srtt {0}, m_rttvar {0}, m_rto {rto_initial}, m_sampled {false}, m_pinned {false} {}
+
+    void RetransmitTimer::updateTimeout() noexcept {
+        const auto spread = std::max<RtoDuration>(rto_granularity, 4 * m_rttvar);
+
+        m_rto = std::clamp<RtoDuration>(m_srtt + spread, rto_min, rto_max);
+    }
+
+    void RetransmitTimer::pin(RtoDuration timeout) noexcept {
+        m_rto = timeout;
+        m_pinned = true;
+    }
+
+    void RetransmitTimer::addSample(RtoDuration rtt) noexcept {
+        if (m_pinned) {
+            return;
+        }
+
+        /// NOTE: RFC 6298 gains, 1/8 for the RTT and 1/4 for its variance.
+        if (not m_sampled) {
+            m_srtt = rtt;
+            m_rttvar = rtt / 2;
+            m_sampled = true;
+        } else {
+            const auto error = (rtt > m_srtt) ? rtt - m_srtt : m_srtt - rtt;
+
+            m_rttvar += (error - m_rttvar) / 4;
+            m_srtt += (rtt - m_srtt) / 8;
+        }
+
+        /// NOTE: a fresh sample also drops any backoff, since the path evidently delivers again.
+        updateTimeout();
+    }
+
+    void RetransmitTimer::backOff() noexcept {
+        if (m_pinned) {
+            return;
+        }
+
+        m_rto = std::min<RtoDuration>(2 * m_rto, rto_max);
+    }
+
+    RtoDuration RetransmitTimer::getTimeout() const noexcept {
+        return m_rto;
+    }
+
+    RtoDuration RetransmitTimer::getSmoothedRtt() const noexcept {
+        return m_srtt;
+    }
+}
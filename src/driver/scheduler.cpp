@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include "mytftp/messaging.hpp"
+#include "driver/session.hpp"
+#include "driver/scheduler.hpp"
+
+namespace TftpServer::Driver {
+    /// NOTE: a bucket holds this much of its rate, but never less than two of the largest DATA messages, or big blocks could never go out.
+    static constexpr auto burst_divisor = 50UL;
+    static constexpr auto min_burst = 2UL * MyTftp::max_packet_size;
+    static constexpr auto nanos_per_second = 1'000'000'000UL;
+
+    [[nodiscard]] static std::size_t toWorkerShare(std::size_t rate, std::size_t worker_count) noexcept {
+        return (rate == 0UL) ? 0UL : std::max(rate / std::max(worker_count, 1UL), 1UL);
+    }
+
+    TokenBucket::TokenBucket() noexcept
+    : TokenBucket {0UL} {}
+
+    TokenBucket::TokenBucket(std::size_t rate) noexcept
+    : m_refilled_at {SchedulerClock::now()}, m_rate {rate}, m_burst {std::max(rate / burst_divisor, min_burst)}, m_tokens {m_burst} {}
+
+    bool TokenBucket::isLimited() const noexcept {
+        return m_rate != 0UL;
+    }
+
+    void TokenBucket::refill(SchedulerClock::time_point now) noexcept {
+        if (not isLimited() or now <= m_refilled_at) {
+            return;
+        }
+
+        /// NOTE: a bucket holds at most a fraction of a second's worth, so a longer gap simply fills it. That also keeps the products below within 64 bits.
+        if (now - m_refilled_at >= std::chrono::seconds {1}) {
+            m_tokens = m_burst;
+            m_refilled_at = now;
+            return;
+        }
+
+        const auto elapsed_ns = static_cast<std::size_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_refilled_at).count());
+        const auto earned = elapsed_ns * m_rate / nanos_per_second;
+
+        /// NOTE: the clock only moves forward by what got paid out, so sub-octet remainders carry into the next refill instead of getting lost.
+        if (earned == 0UL) {
+            return;
+        }
+
+        m_tokens = std::min(m_tokens + earned, m_burst);
+        m_refilled_at = (m_tokens == m_burst) ? now : m_refilled_at + std::chrono::nanoseconds {static_cast<std::int64_t>(earned * nanos_per_second / m_rate)};
+    }
+
+    std::size_t TokenBucket::getTokens() const noexcept {
+        return isLimited() ? m_tokens : std::numeric_limits<std::size_t>::max();
+    }
+
+    void TokenBucket::take(std::size_t amount) noexcept {
+        if (isLimited()) {
+            m_tokens -= std::min(amount, m_tokens);
+        }
+    }
+
+    SendScheduler::SendScheduler(const ServerConfig& config)
+    : m_ready {}, m_entries {}, m_free_entries {}, m_classes {}, m_global {toWorkerShare(config.rate_bytes, config.worker_count)}, m_session_rate {config.session_rate_bytes} {
+        for (const auto& [network, mask, rate_bytes] : config.rate_classes) {
+            m_classes.push_back({network, mask, TokenBucket {toWorkerShare(rate_bytes, config.worker_count)}});
+        }
+    }
+
+    bool SendScheduler::isLimited() const noexcept {
+        return m_global.isLimited() or m_session_rate != 0UL or not m_classes.empty();
+    }
+
+    SendFlow SendScheduler::makeFlow(const sockaddr_in& peer) const noexcept {
+        SendFlow temp {TokenBucket {m_session_rate}, {}, 0UL, {}};
+        const auto peer_ip = peer.sin_addr.s_addr;
+
+        for (auto class_index = 0UL; class_index < m_classes.size(); class_index++) {
+            if ((peer_ip & m_classes[class_index].mask) == m_classes[class_index].network) {
+                temp.class_index = class_index;
+                break;
+            }
+        }
+
+        return temp;
+    }
+
+    void SendScheduler::leave(std::size_t entry_index, SendFlow& flow) noexcept {
+        m_entries[entry_index] = nullptr;
+        m_free_entries.push_back(entry_index);
+        flow.entry.reset();
+        flow.deficit = 0UL;
+    }
+
+    void SendScheduler::enqueue(Session& session, SendFlow& flow) {
+        if (flow.entry.has_value()) {
+            return;
+        }
+
+        if (m_free_entries.empty()) {
+            m_free_entries.push_back(m_entries.size());
+            m_entries.push_back(nullptr);
+        }
+
+        const auto entry_index = m_free_entries.back();
+
+        m_free_entries.pop_back();
+        m_entries[entry_index] = &session;
+        flow.entry = entry_index;
+        m_ready.push_back(entry_index);
+    }
+
+    void SendScheduler::cancel(SendFlow& flow) noexcept {
+        if (not flow.entry.has_value()) {
+            return;
+        }
+
+        /// NOTE: the index stays taken until `service` pops it, so no other session can reuse it while it still waits in line.
+        m_entries[flow.entry.value()] = nullptr;
+        flow.entry.reset();
+        flow.deficit = 0UL;
+    }
+
+    void SendScheduler::service(SchedulerClock::time_point now, std::vector<Session*>& finished) {
+        m_global.refill(now);
+
+        for (auto& class_bucket : m_classes) {
+            class_bucket.bucket.refill(now);
+        }
+
+        /// NOTE: a full pass without any session sending means every one waits on a bucket, so the rest waits for the next tick's refill.
+        auto stalled_n = 0UL;
+
+        while (not m_ready.empty() and stalled_n < m_ready.size()) {
+            const auto entry_index = m_ready.front();
+            auto* session = m_entries[entry_index];
+
+            m_ready.pop_front();
+
+            /// NOTE: the session cancelled while waiting in line, and may already be gone.
+            if (session == nullptr) {
+                m_free_entries.push_back(entry_index);
+                continue;
+            }
+
+            auto& flow = session->getFlow();
+
+            if (session->isDone() or not session->hasPendingBlocks()) {
+                leave(entry_index, flow);
+                continue;
+            }
+
+            flow.bucket.refill(now);
+
+            auto* class_bucket = flow.class_index.has_value() ? &m_classes[flow.class_index.value()].bucket : nullptr;
+            const auto class_tokens = (class_bucket != nullptr) ? class_bucket->getTokens() : std::numeric_limits<std::size_t>::max();
+            const auto token_budget = std::min({flow.bucket.getTokens(), class_tokens, m_global.getTokens()});
+            const auto packet_size = session->getBlockPacketSize();
+
+            /// NOTE: a session waiting on a bucket keeps its place in line but earns no deficit, so it cannot hoard turns for later.
+            if (token_budget < packet_size) {
+                m_ready.push_back(entry_index);
+                stalled_n++;
+
+                if (m_global.getTokens() < packet_size) {
+                    break;
+                }
+
+                continue;
+            }
+
+            /// NOTE: blocks larger than the quantum go out once enough rounds added up, as in deficit round robin.
+            flow.deficit += schedule_quantum;
+
+            if (flow.deficit < packet_size) {
+                m_ready.push_back(entry_index);
+                continue;
+            }
+
+            const auto sent_bytes = session->sendPendingBlocks(std::min(flow.deficit, token_budget));
+
+            flow.deficit -= std::min(sent_bytes, flow.deficit);
+            flow.bucket.take(sent_bytes);
+            m_global.take(sent_bytes);
+
+            if (class_bucket != nullptr) {
+                class_bucket->take(sent_bytes);
+            }
+
+            stalled_n = (sent_bytes == 0UL) ? stalled_n + 1UL : 0UL;
+
+            if (session->isDone()) {
+                leave(entry_index, flow);
+                finished.push_back(session);
+            } else if (not session->hasPendingBlocks()) {
+                leave(entry_index, flow);
+            } else {
+                m_ready.push_back(entry_index);
+            }
+        }
+    }
+}
@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include "mybsock/netconfig.hpp"
+#include "driver/server.hpp"
+
+namespace TftpServer::Driver {
+    static constexpr const char* ephemeral_port_cstr = "0";
+    static constexpr auto max_reactor_events = 64UL;
+    /// NOTE: matches the timer wheel's tick, so session timers fire within one tick of their RTO.
+    static constexpr auto session_tick_period = rto_granularity;
+    /// NOTE: one session flushes at most a batch of reads plus a batch of sends at a time.
+    static constexpr auto ring_entries = 4U * static_cast<unsigned int>(session_batch_size);
+    /// NOTE: sessions past this many on one worker read without registered buffers.
+    static constexpr auto ring_buffer_slots = 1024U;
+    /// NOTE: session cells per slab page.
+    static constexpr auto session_slab_page = 32UL;
+
+    MyBSock::UDPServerSocket makeUDPSocket(const char* port_cstr, bool reuse_port) {
+        MyBSock::SocketGenerator sockgen {port_cstr, reuse_port};
+
+        while (sockgen) {
+            auto fd_optional = sockgen();
+
+            if (fd_optional.has_value()) {
+                return {fd_optional.value()};
+            }
+        }
+
+        return {};
+    }
+
+    void MyServer::readRequests() {
+        /// NOTE: a burst of requests is taken a batch per syscall until the listener runs dry.
+        while (m_socket.recieveBatch(m_request_batch) == MyBSock::IOStatus::ok) {
+            const auto filled_n = m_request_batch.getFilled();
+
+            bumpCounter(m_resources.metrics->packets_in, filled_n);
+
+            for (auto slot_index = 0UL; slot_index < filled_n; slot_index++) {
+                auto& buffer = m_request_buffers[slot_index];
+
+                buffer.markLength(m_request_batch.getLength(slot_index));
+                handleRequest({
+                    MyTftp::parseMessage(buffer),
+                    m_request_batch.getPeer(slot_index)
+                });
+            }
+
+            if (filled_n < m_request_batch.getCount()) {
+                break;
+            }
+        }
+    }
+
+    void MyServer::handleRequest(const ReadResult& read_result) {
+        const auto& [msg, io_result] = read_result;
+
+        if (io_result.status != MyBSock::IOStatus::ok) {
+            return;
+        }
+
+        const auto opcode = msg.op;
+        logEvent<LogLevel::debug>(makeLogOrigin(m_worker_id, 0U, io_result.data), "request opcode={}", static_cast<int>(opcode));
+
+        if (opcode != MyTftp::Opcode::rrq and opcode != MyTftp::Opcode::wrq) {
+            sendError(MyTftp::ErrorCode::bad_operation, io_result);
+            return;
+        }
+
+        const auto peer_key = makePeerKey(io_result.data);
+
+        /// NOTE: the peer repeated its request because our first reply got lost, so the existing session just answers again.
+        if (auto* existing = m_sessions.find(peer_key); existing != nullptr) {
+            existing->onRepeatedRequest();
+            noteFinished(*existing);
+            return;
+        }
+
+        /// NOTE: per RFC 2090, a client asking to multicast a file which already streams joins that transfer instead of opening its own.
+        if (m_resources.multicast != nullptr and opcode == MyTftp::Opcode::rrq) {
+            if (auto* transfer = m_multicast.findTransfer(std::get<MyTftp::RWPayload>(msg.payload)); transfer != nullptr and transfer->addMember(msg, io_result)) {
+                noteFinished(*transfer);
+                return;
+            }
+        }
+
+        /// NOTE: the session cap keeps the footprint within what got reported at startup.
+        if (m_sessions.getSize() >= m_max_sessions) {
+            sendError(MyTftp::ErrorCode::storage_issue, io_result);
+            return;
+        }
+
+        auto session_socket = makeUDPSocket(ephemeral_port_cstr);
+
+        /// NOTE: e.g. the worker ran out of descriptors, so the peer hears right away instead of retrying into the same wall.
+        if (not session_socket.isUsable()) {
+            logEvent<LogLevel::warn>(makeLogOrigin(m_worker_id, 0U, io_result.data), "no socket for a new session");
+            sendError(MyTftp::ErrorCode::not_defined, io_result);
+            return;
+        }
+
+        /// NOTE: the wheel stood still while the worker was idle, so it catches up before the session's first timer lands in it.
+        if (not m_ticking) {
+            m_timers.catchUp(SessionClock::now());
+        }
+
+        auto session = m_session_slab.make(m_next_session_id++, std::move(session_socket), io_result, m_resources);
+        session->start(msg);
+
+        if (session->isDone()) {
+            return;
+        }
+
+        if (not m_reactor.watch(session->getFd(), session.get())) {
+            sendError(MyTftp::ErrorCode::not_defined, io_result);
+            return;
+        }
+
+        logEvent<LogLevel::info>(makeLogOrigin(m_worker_id, session->getId(), io_result.data), "opened session, active={}", m_sessions.getSize() + 1);
+
+        const auto session_fd = session->getFd();
+
+        if (not m_sessions.insert(peer_key, std::move(session))) {
+            m_reactor.unwatch(session_fd);
+            sendError(MyTftp::ErrorCode::not_defined, io_result);
+            return;
+        }
+
+        m_resources.metrics->active_sessions.store(m_sessions.getSize(), std::memory_order_relaxed);
+    }
+
+    void MyServer::sendError(MyTftp::ErrorCode error_code, const MyBSock::IOResult& prev_io) {
+        sendErrorTo(m_socket, m_buffer, error_code, prev_io);
+        bumpCounter(m_resources.metrics->packets_out);
+        bumpCounter(m_resources.metrics->errors_sent[static_cast<std::size_t>(error_code)]);
+
+        logEvent<LogLevel::info>(makeLogOrigin(m_worker_id, 0U, prev_io.data), "sent error {}", static_cast<int>(error_code));
+    }
+
+    void MyServer::noteFinished(Session& session) {
+        if (session.isDone()) {
+            m_finished.push_back(&session);
+        }
+    }
+
+    void MyServer::expireTimers() {
+        const auto now = SessionClock::now();
+
+        /// NOTE: only sessions whose deadline passed get touched, so a tick costs nothing for the many transfers which are just waiting.
+        m_timers.advance(now, [this, now](Session& session) {
+            session.onTick(now);
+            noteFinished(session);
+        });
+    }
+
+    void MyServer::reapSessions() {
+        if (m_finished.empty()) {
+            return;
+        }
+
+        /// NOTE: a session may have ended through several paths in one round, but gets closed once.
+        std::ranges::sort(m_finished);
+        const auto [dup_begin, dup_end] = std::ranges::unique(m_finished);
+        m_finished.erase(dup_begin, dup_end);
+
+        for (auto* session : m_finished) {
+            logEvent<LogLevel::info>({m_worker_id, session->getId(), 0, 0}, "closed session");
+            m_reactor.unwatch(session->getFd());
+            static_cast<void>(m_sessions.erase(session->getKey()));
+        }
+
+        m_finished.clear();
+        m_resources.metrics->active_sessions.store(m_sessions.getSize(), std::memory_order_relaxed);
+    }
+
+    void MyServer::updateTicks() {
+        /// NOTE: retransmit timers only matter while transfers are live, so an idle server never wakes up.
+        if (const auto want_ticks = not m_sessions.isEmpty(); want_ticks != m_ticking) {
+            m_ticking = m_reactor.armTicks(want_ticks ? session_tick_period : std::chrono::milliseconds {0}) and want_ticks;
+        }
+    }
+
+    void MyServer::reportFootprint(const ServerConfig& config) const {
+        /// NOTE: a transfer's buffers scale with its window and block size, from an RFC 1350 default transfer up to the largest one the server negotiates.
+        const auto default_bytes = estimatePacketBytes(MyTftp::Opcode::rrq, MyTftp::DataMode::octet, MyTftp::default_block_size, MyTftp::min_window_size);
+        const auto largest_bytes = estimatePacketBytes(MyTftp::Opcode::rrq, MyTftp::DataMode::netascii, MyTftp::max_block_size, session_max_window);
+        const auto session_bytes = MyBSock::ObjectSlab<Session>::cell_size;
+        const auto worst_bytes = std::min(m_max_sessions * largest_bytes, config.pool_bytes) + m_max_sessions * session_bytes;
+
+        logEvent<LogLevel::info>({m_worker_id, 0U, 0, 0}, "footprint: {} sessions x ({}B state + {}B..{}B packets), packet pool capped at {}B, worst case {}B, huge-pages={}", m_max_sessions, session_bytes, default_bytes, largest_bytes, config.pool_bytes, worst_bytes, config.huge_pages);
+    }
+
+    MyServer::MyServer(MyBSock::UDPServerSocket socket, const SessionResources& resources, unsigned int worker_id, const ServerConfig& config)
+    : m_ring {}, m_packet_pool {config.pool_bytes, config.huge_pages}, m_scheduler {config}, m_multicast {config, worker_id}, m_timers {}, m_session_slab {session_slab_page}, m_sessions {config.max_sessions}, m_finished {}, m_resources {resources}, m_reactor {}, m_request_buffers {}, m_request_batch {}, m_buffer {}, m_socket {std::move(socket)}, m_max_sessions {config.max_sessions}, m_next_session_id {1U}, m_worker_id {worker_id}, m_ticking {false} {
+        for (auto& buffer : m_request_buffers) {
+            static_cast<void>(m_request_batch.bindReceive(buffer));
+        }
+
+        m_finished.reserve(m_max_sessions);
+        m_resources.packet_pool = &m_packet_pool;
+        m_resources.scheduler = m_scheduler.isLimited() ? &m_scheduler : nullptr;
+        m_resources.multicast = m_multicast.isEnabled() ? &m_multicast : nullptr;
+        m_resources.timers = &m_timers;
+        m_resources.reactor = &m_reactor;
+        m_resources.worker_id = m_worker_id;
+
+        if (config.io_backend == IoBackend::uring) {
+            try {
+                m_ring = std::make_unique<MyBSock::IoRing>(ring_entries, ring_buffer_slots);
+                m_resources.io_ring = m_ring.get();
+            } catch (const std::runtime_error& ring_error) {
+                logEvent<LogLevel::warn>({m_worker_id, 0U, 0, 0}, "falls back to epoll: {}", ring_error.what());
+            }
+        }
+
+        reportFootprint(config);
+    }
+
+    void MyServer::requestStop() const noexcept {
+        m_reactor.requestStop();
+    }
+
+    bool MyServer::runService() {
+        if (not m_socket.isUsable() or not m_reactor.watch(m_socket.getFd(), &m_socket)) {
+            return false;
+        }
+
+        std::array<MyBSock::ReactorEvent, max_reactor_events> events;
+        auto persist = true;
+
+        while (persist) {
+            const auto event_count = m_reactor.waitEvents(events);
+
+            for (auto event_index = 0UL; event_index < event_count; event_index++) {
+                const auto& [context, count, kind] = events[event_index];
+
+                if (kind == MyBSock::EventKind::stop) {
+                    persist = false;
+                } else if (kind == MyBSock::EventKind::tick) {
+                    expireTimers();
+                } else if (context == &m_socket) {
+                    readRequests();
+                } else if (kind == MyBSock::EventKind::writable) {
+                    auto* session = static_cast<Session*>(context);
+
+                    session->onWritable();
+                    noteFinished(*session);
+                } else {
+                    auto* session = static_cast<Session*>(context);
+
+                    session->onReadable();
+                    noteFinished(*session);
+                }
+            }
+
+            /// NOTE: paced sessions only queued their windows while handling events, so the blocks go out here, round robin across all of them.
+            if (m_resources.scheduler != nullptr) {
+                m_scheduler.service(SchedulerClock::now(), m_finished);
+            }
+
+            reapSessions();
+            updateTicks();
+        }
+
+        logEvent<LogLevel::info>({m_worker_id, 0U, 0, 0}, "stopping with {} active sessions", m_sessions.getSize());
+        return true;
+    }
+}
@@ -0,0 +1,1091 @@
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <limits>
+#include <utility>
+#include <arpa/inet.h>
+#include "mybsock/netconfig.hpp"
+#include "driver/session.hpp"
+
+namespace TftpServer::Driver {
+    /// NOTE: IPv4 and UDP headers, which the path MTU must also fit besides a DATA message.
+    static constexpr auto udp_ipv4_overhead = 28UL;
+    /// NOTE: ring completions of sends carry this bit over their batch slot, while those of reads carry their slot index.
+    static constexpr auto ring_send_flag = std::uint64_t {1} << 63U;
+
+    const std::array<std::string, static_cast<std::size_t>(MyTftp::ErrorCode::last) + 1> server_error_msgs = {
+        "OK!",
+        "Internal server error: reply corrupted / bad request args.",
+        "File not found.",
+        "File access violation.",
+        "Disk full or allocation exceeded.",
+        "Invalid operation.",
+        "Unknown transfer ID.",
+        "File already exists.",
+        "No such user.",
+        "Option negotiation refused.",
+    };
+
+    std::size_t PeerKeyHash::operator()(const PeerKey& key) const noexcept {
+        auto packed = (static_cast<std::uint64_t>(key.ip) << 16) | static_cast<std::uint64_t>(key.port);
+
+        /// NOTE: MurmurHash3's finalizer, since tables mask off the low bits, and hosts sharing a source port must still land apart.
+        packed ^= packed >> 33;
+        packed *= 0xff51afd7ed558ccdUL;
+        packed ^= packed >> 33;
+        packed *= 0xc4ceb9fe1a85ec53UL;
+        packed ^= packed >> 33;
+
+        return static_cast<std::size_t>(packed);
+    }
+
+    PeerKey makePeerKey(const sockaddr_in& address) noexcept {
+        return { address.sin_addr.s_addr, address.sin_port };
+    }
+
+    /// NOTE: an RRQ peer only sends ACKs and ERRORs, while a WRQ peer sends whole blocks. Every receive slot also fits an outgoing ERROR.
+    [[nodiscard]] static std::size_t toRxSlotSize(MyTftp::Opcode op, std::size_t block_size) noexcept {
+        return (op == MyTftp::Opcode::rrq) ? io_buffer_size : std::max(MyTftp::data_header_size + block_size, io_buffer_size);
+    }
+
+    [[nodiscard]] static std::size_t toRxSlotCount(MyTftp::Opcode op, std::size_t window_size) noexcept {
+        return (op == MyTftp::Opcode::rrq) ? session_batch_size : std::min(window_size, session_batch_size);
+    }
+
+    std::optional<PacketSlots> makePacketSlots(MyBSock::PacketPool& pool, std::size_t slot_count, std::size_t slot_size) noexcept {
+        const auto slot_stride = MyBSock::roundToCacheLine(slot_size);
+        const auto run = pool.acquire(slot_count * slot_stride);
+
+        if (not run.has_value()) {
+            return {};
+        }
+
+        PacketSlots temp {
+            .run = run.value(),
+            .slots = {},
+            .count = std::min(slot_count, session_batch_size)
+        };
+
+        for (auto slot_index = 0UL; slot_index < temp.count; slot_index++) {
+            temp.slots[slot_index] = PacketSlot {temp.run.ptr + slot_index * slot_stride, slot_size};
+        }
+
+        return temp;
+    }
+
+    /// NOTE: decoding a block may carry one CR over from the block before and flush one at the end, hence two spare octets.
+    [[nodiscard]] static std::size_t toAsciiSlotSize(std::size_t block_size) noexcept {
+        return block_size + 2UL;
+    }
+
+    std::size_t estimatePacketBytes(MyTftp::Opcode op, MyTftp::DataMode mode, std::size_t block_size, std::size_t window_size) noexcept {
+        const auto rx_bytes = toRxSlotCount(op, window_size) * MyBSock::roundToCacheLine(toRxSlotSize(op, block_size));
+        const auto tx_bytes = std::min(window_size, session_batch_size) * MyBSock::roundToCacheLine(MyTftp::data_header_size + block_size);
+        const auto rx_run = MyBSock::PacketPool::getRunSize(rx_bytes);
+        const auto ascii_run = (mode == MyTftp::DataMode::netascii) ? MyBSock::PacketPool::getRunSize(toAsciiSlotSize(block_size)) : 0UL;
+
+        return ((op == MyTftp::Opcode::rrq) ? rx_run + MyBSock::PacketPool::getRunSize(tx_bytes) : rx_run) + ascii_run;
+    }
+
+    bool Session::writeNextFileChunk(MyTftp::OctetSpan chunk, bool last_chunk) {
+        if (m_mode == MyTftp::DataMode::netascii) {
+            auto* ascii_ptr = m_ascii_slots.slots[0].getPtr();
+            auto ascii_n = MyTftp::decodeNetascii(chunk, ascii_ptr, m_ascii_carry);
+
+            if (last_chunk) {
+                ascii_n += MyTftp::finishNetasciiDecode(ascii_ptr + ascii_n, m_ascii_carry);
+            }
+
+            chunk = MyTftp::OctetSpan {ascii_ptr, ascii_n};
+        }
+
+        if (m_upload.has_value()) {
+            return m_upload->append(chunk.data(), chunk.size());
+        }
+
+        return m_ctx.file.writeAll(chunk.data(), chunk.size());
+    }
+
+    long Session::readNetasciiBlock(std::uint64_t block_index, MyTftp::tftp_u8* target) {
+        auto [file_offset, carry] = m_ascii_cursors[block_index % m_ascii_cursors.size()];
+        auto* raw_ptr = m_ascii_slots.slots[0].getPtr();
+
+        /// NOTE: every file octet yields at least one netascii octet, so a block never needs more than its size in file octets.
+        const auto raw_n = (m_cached != nullptr)
+            ? m_cached->readAt(raw_ptr, m_block_size, file_offset, m_ctx.file)
+            : m_ctx.file.readAt(raw_ptr, m_block_size, file_offset);
+
+        if (raw_n < 0) {
+            return -1L;
+        }
+
+        const auto [consumed_n, produced_n] = MyTftp::encodeNetascii({raw_ptr, static_cast<std::size_t>(raw_n)}, target, m_block_size, carry);
+
+        m_ascii_cursors[(block_index + 1U) % m_ascii_cursors.size()] = {file_offset + consumed_n, carry};
+
+        return static_cast<long>(produced_n);
+    }
+
+    void Session::handleMessage(const MyTftp::MessageView& msg, const MyBSock::IOResult& io_result) {
+        const auto opcode = msg.op;
+        logEvent<LogLevel::debug>(makeLogOrigin(m_resources.worker_id, m_id, io_result.data), "opcode={}", static_cast<int>(opcode));
+
+        switch (opcode) {
+        case MyTftp::Opcode::data:
+            sendAck(std::get<MyTftp::DataView>(msg.payload));
+            break;
+        case MyTftp::Opcode::ack:
+            sendDataMessage(std::get<MyTftp::AckView>(msg.payload));
+            break;
+        case MyTftp::Opcode::err:
+            if (m_group.has_value()) {
+                promoteNextMember();
+            } else {
+                m_ctx.done = true;
+            }
+            break;
+        default:
+            sendError(MyTftp::ErrorCode::bad_operation, io_result);
+            break;
+        }
+    }
+
+    bool Session::handleMemberMessage(const MyTftp::MessageView& msg, const MyBSock::IOResult& io_result) {
+        const auto member_it = findMember(makePeerKey(io_result.data));
+
+        if (member_it == m_members.end()) {
+            return false;
+        }
+
+        /// NOTE: members only listen until their turn as master, but may leave early with an ERROR, or with the last block's ACK once they hold every block.
+        const auto leaving = msg.op == MyTftp::Opcode::err
+            or (msg.op == MyTftp::Opcode::ack and std::get<MyTftp::AckView>(msg.payload).block_n == static_cast<MyTftp::tftp_u16>(m_last_index));
+
+        if (leaving) {
+            m_members.erase(member_it);
+        }
+
+        return true;
+    }
+
+    std::deque<MulticastMember>::iterator Session::findMember(const PeerKey& peer_key) {
+        return std::ranges::find_if(m_members, [&peer_key](const MulticastMember& member) {
+            return makePeerKey(member.peer.data) == peer_key;
+        });
+    }
+
+    MyTftp::OptionList Session::addMulticastOption(MyTftp::OptionList accepted, bool master) const {
+        std::array<char, INET_ADDRSTRLEN> group_text {};
+
+        inet_ntop(AF_INET, &m_group->address.sin_addr, group_text.data(), group_text.size());
+
+        /// NOTE: RFC 2090 answers with `<group>,<port>,<mc>`, where mc=1 tells the client it is the master and has to ACK.
+        accepted.push_back({MyTftp::option_name_multicast, std::string {group_text.data()} + "," + std::to_string(ntohs(m_group->address.sin_port)) + (master ? ",1" : ",0")});
+
+        return accepted;
+    }
+
+    const sockaddr_in& Session::getDataTarget() const noexcept {
+        return m_group.has_value() ? m_group->address : m_peer.data;
+    }
+
+    void Session::sendMemberOAck(const MulticastMember& member) {
+        /// NOTE: joins come from the listener between reads, so the first receive slot is free, and the master's last reply stays intact.
+        auto& slot = m_rx_slots.slots[0];
+
+        slot.reset();
+
+        if (not MyTftp::serializeMessage(slot, MyTftp::Message {
+            MyTftp::Opcode::oack,
+            MyTftp::OAckPayload {
+                addMulticastOption(member.accepted, false)
+            }
+        })) {
+            return;
+        }
+
+        m_socket.sendTo(slot, slot.getLength(), member.peer);
+        bumpCounter(m_resources.metrics->packets_out);
+    }
+
+    void Session::promoteNextMember() {
+        if (m_members.empty()) {
+            m_ctx.done = true;
+            return;
+        }
+
+        auto next_master = std::move(m_members.front());
+
+        m_members.pop_front();
+
+        /// NOTE: per RFC 2090, the new master answers with the ACK of the block before its first missing one, which restarts the stream there for every member.
+        m_peer = next_master.peer;
+        m_window_size = next_master.window_size;
+        m_acked_index = 0;
+        m_sent_index = 0;
+        m_pending_index = m_pending_end;
+        m_retries = 0;
+        m_resume_pending = false;
+        m_rtt_probe.reset();
+
+        logEvent<LogLevel::info>(makeLogOrigin(m_resources.worker_id, m_id, m_peer.data), "promoted to multicast master, members={}", m_members.size());
+        sendOAck(addMulticastOption(std::move(next_master.accepted), true));
+    }
+
+    bool Session::openTransferFile(MyTftp::Opcode op, const std::string& filename) {
+        m_ctx.block = 0;
+        m_ctx.done = false;
+
+        if (op == MyTftp::Opcode::rrq) {
+            m_ctx.file = FileHandle {filename};
+
+            if (not m_ctx.file.isOpen()) {
+                sendError(MyTftp::ErrorCode::file_not_found, m_peer);
+                return false;
+            }
+
+            return true;
+        }
+
+        m_ctx.file = FileHandle {filename, FileAccess::write};
+
+        if (not m_ctx.file.isOpen()) {
+            sendError(MyTftp::ErrorCode::access_violation, m_peer);
+            return false;
+        }
+
+        if (m_resources.file_writer != nullptr) {
+            m_upload.emplace(*m_resources.file_writer, std::move(m_ctx.file));
+        }
+
+        return true;
+    }
+
+    std::size_t Session::findBlockSizeLimit() const {
+        const auto path_mtu = MyBSock::queryPathMtu(m_peer.data);
+
+        /// NOTE: larger blocks would get IP-fragmented, where one lost fragment costs the whole block.
+        if (not path_mtu.has_value() or path_mtu.value() <= udp_ipv4_overhead + MyTftp::data_header_size + MyTftp::min_block_size) {
+            return MyTftp::max_block_size;
+        }
+
+        return path_mtu.value() - udp_ipv4_overhead - MyTftp::data_header_size;
+    }
+
+    void Session::sendOAck(const MyTftp::OptionList& accepted) {
+        m_tx_buffer.reset();
+
+        if (not MyTftp::serializeMessage(m_tx_buffer, MyTftp::Message {
+            MyTftp::Opcode::oack,
+            MyTftp::OAckPayload {
+                accepted
+            }
+        })) {
+            sendError(MyTftp::ErrorCode::not_defined, m_peer);
+            return;
+        }
+
+        sendReply();
+        startRttProbe(0U);
+    }
+
+    void Session::sendWindow(std::uint64_t first_index) {
+        if (m_resources.scheduler == nullptr) {
+            static_cast<void>(sendBlocks(first_index, m_window_size));
+            return;
+        }
+
+        /// NOTE: with pacing on, the window only gets marked as waiting. Its blocks go out as the scheduler hands this session turns.
+        m_pending_index = first_index;
+        m_pending_end = first_index + m_window_size;
+        m_resources.scheduler->enqueue(*this, m_flow);
+    }
+
+    std::size_t Session::sendBlocks(std::uint64_t first_index, std::size_t block_count) {
+        /// NOTE: a new window starts at or before any blocks a full socket buffer still holds back, so those get rebuilt instead.
+        m_tx_batch.clear();
+
+        if (m_encoded != nullptr) {
+            return sendEncodedBlocks(first_index, block_count);
+        }
+
+        const auto window_end = first_index + block_count;
+        const auto fresh_window = first_index > m_sent_index;
+        auto slot_index = 0UL;
+        auto sent_bytes = 0UL;
+
+        for (auto block_index = first_index; block_index < window_end; block_index++) {
+            auto& slot = m_tx_slots.slots[slot_index++];
+
+            if (not MyTftp::serializeDataHeader(slot, static_cast<MyTftp::tftp_u16>(block_index))) {
+                dropWindow();
+                sendError(MyTftp::ErrorCode::not_defined, m_peer);
+                return sent_bytes;
+            }
+
+            /// NOTE: the block lands right after the header, and its offset follows from its number, so resuming after a loss needs no seek.
+            auto* chunk_ptr = slot.getPtr() + MyTftp::data_header_size;
+            const auto chunk_offset = (block_index - 1U) * m_block_size;
+            auto chunk_length = -1L;
+
+            /// NOTE: with a ring, uncached blocks are only queued here, each read with its block's send linked behind it. The pairs run in parallel, so reads overlap the sends of blocks already read.
+            if (m_mode == MyTftp::DataMode::netascii) {
+                chunk_length = readNetasciiBlock(block_index, chunk_ptr);
+            } else if (m_resources.io_ring != nullptr and m_cached == nullptr and m_file_size.has_value()) {
+                const auto ring_length = std::min<std::uint64_t>(m_block_size, m_file_size.value() - std::min(chunk_offset, m_file_size.value()));
+                const auto batch_index = m_tx_batch.getCount();
+
+                /// NOTE: the send points at the batch header this block fills further below, which is complete long before the ring gets submitted.
+                if (ring_length == 0U) {
+                    chunk_length = 0L;
+                } else if (m_resources.io_ring->queueReadSend(m_ctx.file.getFd(), chunk_ptr, static_cast<unsigned int>(ring_length), chunk_offset, m_ring_buffer, slot_index - 1UL, m_socket.getFd(), m_tx_batch.getMessage(batch_index), ring_send_flag | batch_index)) {
+                    chunk_length = static_cast<long>(ring_length);
+                    m_ring_linked.set(batch_index);
+                }
+            }
+
+            if (chunk_length < 0) {
+                chunk_length = (m_cached != nullptr)
+                    ? m_cached->readAt(chunk_ptr, m_block_size, chunk_offset, m_ctx.file)
+                    : m_ctx.file.readAt(chunk_ptr, m_block_size, chunk_offset);
+            }
+
+            if (chunk_length < 0) {
+                dropWindow();
+                sendError(MyTftp::ErrorCode::access_violation, m_peer);
+                return sent_bytes;
+            }
+
+            slot.markLength(MyTftp::data_header_size + static_cast<std::size_t>(chunk_length));
+            bumpCounter(m_resources.metrics->data_bytes_out, static_cast<std::uint64_t>(chunk_length));
+            static_cast<void>(m_tx_batch.queueSend(slot, slot.getLength(), getDataTarget()));
+            sent_bytes += slot.getLength();
+            m_sent_index = block_index;
+
+            if (static_cast<std::size_t>(chunk_length) < m_block_size) {
+                m_last_index = block_index;
+                break;
+            }
+
+            if (slot_index == m_tx_slots.count) {
+                flushWindow();
+                slot_index = 0;
+
+                /// NOTE: the slots still hold blocks waiting for room, so the rest of the window goes out after the peer's next ACK or a timeout.
+                if (m_awaiting_writable) {
+                    break;
+                }
+            }
+        }
+
+        flushWindow();
+
+        if (fresh_window and not m_ctx.done) {
+            startRttProbe(m_sent_index);
+        }
+
+        return sent_bytes;
+    }
+
+    std::size_t Session::sendEncodedBlocks(std::uint64_t first_index, std::size_t block_count) {
+        const auto window_end = std::min<std::uint64_t>(first_index + block_count, m_encoded->getBlockCount() + 1U);
+        const auto fresh_window = first_index > m_sent_index;
+        auto sent_bytes = 0UL;
+
+        /// NOTE: the messages already sit in the cache as they go out, so a window costs no file reads or encoding, only the sends.
+        for (auto block_index = first_index; block_index < window_end; block_index++) {
+            const auto packet = m_encoded->getPacket(block_index);
+
+            static_cast<void>(m_tx_batch.queueSend(packet, getDataTarget()));
+            bumpCounter(m_resources.metrics->data_bytes_out, packet.size() - MyTftp::data_header_size);
+            sent_bytes += packet.size();
+            m_sent_index = block_index;
+
+            if (packet.size() < getBlockPacketSize()) {
+                m_last_index = block_index;
+                break;
+            }
+
+            if (m_tx_batch.getCount() == m_tx_batch.getCapacity()) {
+                flushWindow();
+
+                if (m_awaiting_writable) {
+                    break;
+                }
+            }
+        }
+
+        flushWindow();
+
+        if (fresh_window and not m_ctx.done) {
+            startRttProbe(m_sent_index);
+        }
+
+        return sent_bytes;
+    }
+
+    void Session::flushWindow() {
+        if (m_tx_batch.getCount() == 0UL) {
+            return;
+        }
+
+        if (m_resources.io_ring != nullptr) {
+            flushWindowRing();
+        } else {
+            pushBatch();
+        }
+
+        armRetry(SessionClock::now() + m_rto.getTimeout());
+    }
+
+    void Session::pushBatch() {
+        const auto queued_n = m_tx_batch.getUnsent();
+        const auto left_n = (m_socket.sendBatch(m_tx_batch) == MyBSock::IOStatus::would_block) ? m_tx_batch.getUnsent() : 0UL;
+
+        bumpCounter(m_resources.metrics->packets_out, queued_n - left_n);
+        watchWritable(left_n > 0UL);
+    }
+
+    void Session::watchWritable(bool writable) noexcept {
+        if (writable != m_awaiting_writable and m_resources.reactor->watchWritable(getFd(), this, writable)) {
+            m_awaiting_writable = writable;
+        }
+    }
+
+    void Session::dropWindow() {
+        /// NOTE: reads already queued on the ring still target this session's slots, so they must finish before the session may go away.
+        if (m_resources.io_ring != nullptr) {
+            static_cast<void>(m_resources.io_ring->submitAndWait());
+
+            for (MyBSock::IoCompletion completion {}; m_resources.io_ring->popCompletion(completion);) {}
+        }
+
+        m_tx_batch.clear();
+        m_ring_linked.reset();
+    }
+
+    void Session::flushWindowRing() {
+        auto& io_ring = *m_resources.io_ring;
+        std::bitset<session_batch_size> send_failed;
+        auto read_failed = false;
+
+        /// NOTE: blocks whose octets were ready without a ring read still need their sends queued. Those finding the ring full go out through the socket below.
+        for (auto slot_index = 0UL; slot_index < m_tx_batch.getCount(); slot_index++) {
+            if (not m_ring_linked.test(slot_index) and not io_ring.queueSend(m_socket.getFd(), m_tx_batch.getMessage(slot_index), ring_send_flag | slot_index)) {
+                send_failed.set(slot_index);
+            }
+        }
+
+        /// NOTE: one enter covers the window's reads and sends. The batch's headers must outlive it, so the batch is cleared only after every completion came in.
+        static_cast<void>(io_ring.submitAndWait());
+
+        for (MyBSock::IoCompletion completion {}; io_ring.popCompletion(completion);) {
+            /// NOTE: a send cancelled behind its failed read counts as that read's failure, while any other error, e.g. -EAGAIN on a full socket buffer, gets its block sent again.
+            if ((completion.tag & ring_send_flag) != 0U) {
+                if (completion.result < 0 and completion.result != -ECANCELED) {
+                    send_failed.set(completion.tag & ~ring_send_flag);
+                }
+
+                continue;
+            }
+
+            const auto expected_length = m_tx_slots.slots[completion.tag].getLength() - MyTftp::data_header_size;
+
+            read_failed = read_failed or completion.result != static_cast<int>(expected_length);
+        }
+
+        m_ring_linked.reset();
+
+        /// NOTE: a failed or short read breaks its link, so its block never went out, and the transfer gets aborted instead of stalling on it.
+        if (read_failed) {
+            m_tx_batch.clear();
+            sendError(MyTftp::ErrorCode::access_violation, m_peer);
+            return;
+        }
+
+        bumpCounter(m_resources.metrics->packets_out, m_tx_batch.getCount() - send_failed.count());
+        m_tx_batch.retainSends(send_failed);
+
+        if (m_tx_batch.getCount() > 0UL) {
+            pushBatch();
+        }
+    }
+
+    void Session::sendDataMessage(const MyTftp::AckView& ack) {
+        const auto ack_block_n = ack.block_n;
+
+        /// NOTE: block numbers wrap at 16 bits, so an ACK is placed by its distance past the last ACKed block. Stale ACKs land beyond the sent blocks.
+        const auto ack_distance = static_cast<MyTftp::tftp_u16>(ack_block_n - static_cast<MyTftp::tftp_u16>(m_acked_index));
+        auto ack_index = m_acked_index + ack_distance;
+
+        /// NOTE: a multicast master may hold blocks from before its turn, so its ACKs may skip past the sent ones up to the last block. Its first ACK counts from the file's start.
+        if (m_group.has_value()) {
+            ack_index = (m_sent_index == 0U) ? ack_block_n : ack_index;
+
+            if (ack_index > m_last_index) {
+                return;
+            }
+
+            m_sent_index = std::max(m_sent_index, ack_index);
+        }
+
+        if (ack_index > m_sent_index) {
+            return;
+        }
+
+        /// NOTE: without windowing, a duplicate ACK must not trigger another send, or both sides end up re-sending every block (Sorcerer's Apprentice bug).
+        if (m_window_size == MyTftp::min_window_size and ack_index == m_acked_index and ack_index != m_sent_index) {
+            return;
+        }
+
+        finishRttProbe(ack_index);
+        m_acked_index = ack_index;
+        m_ctx.block = static_cast<MyTftp::tftp_u16>(ack_index);
+
+        if (m_last_index != 0U and ack_index == m_last_index) {
+            if (m_group.has_value()) {
+                promoteNextMember();
+            } else {
+                m_ctx.done = true;
+            }
+
+            return;
+        }
+
+        /// NOTE: per RFC 7440, an ACK short of the window's end reports a lost block, so sending resumes right after it. That waits for the rest of the received batch, as a later ACK there may move it further.
+        m_resume_pending = true;
+    }
+
+    void Session::sendAckMessage() {
+        if (not MyTftp::serializeAckView(m_tx_buffer, m_ctx.block)) {
+            sendError(MyTftp::ErrorCode::not_defined, m_peer);
+            return;
+        }
+
+        /// NOTE: the final ACK tells the peer its upload is stored, so the file gets flushed before that.
+        if (m_ctx.done) {
+            m_ctx.file.close();
+        }
+
+        m_window_received = 0;
+        sendReply();
+        startRttProbe(m_ctx.block);
+    }
+
+    void Session::sendAck(const MyTftp::DataView& data) {
+        const auto& [data_block_n, chunk] = data;
+
+        /// NOTE: the peer re-sent its last block while the file is still being synced, and it gets the final ACK once that is done.
+        if (m_store_pending) {
+            return;
+        }
+
+        /// NOTE: the peer re-sent the block we already have, so our ACK for it was probably lost.
+        if (data_block_n == m_ctx.block) {
+            sendAckMessage();
+            m_rtt_probe.reset();
+            return;
+        }
+
+        if (data_block_n != static_cast<MyTftp::tftp_u16>(m_ctx.block + 1U)) {
+            /// NOTE: validate block num. to check chunk ordering... a mis-ordered chunk would result in the wrong file contents!
+            if (m_window_size == MyTftp::min_window_size) {
+                sendError(MyTftp::ErrorCode::not_defined, m_peer);
+            } else if (not m_gap_reported) {
+                /// NOTE: a block went missing within the window, so the last in-order block is ACKed once for the peer to resume after it.
+                m_gap_reported = true;
+                sendAckMessage();
+            }
+
+            return;
+        }
+
+        if (chunk.size() > m_block_size) {
+            sendError(MyTftp::ErrorCode::bad_operation, m_peer);
+            return;
+        }
+
+        if (not writeNextFileChunk(chunk, chunk.size() < m_block_size)) {
+            sendError(MyTftp::ErrorCode::storage_issue, m_peer);
+            return;
+        }
+
+        bumpCounter(m_resources.metrics->data_bytes_in, chunk.size());
+
+        finishRttProbe(m_ctx.block);
+        m_ctx.block = data_block_n;
+        m_gap_reported = false;
+        m_window_received++;
+
+        /// NOTE: the final ACK tells the peer its upload is stored, so with write-behind it waits for the writer's sync. The timer polls for that every tick.
+        if (chunk.size() < m_block_size and m_upload.has_value()) {
+            m_store_pending = true;
+            m_upload->finish();
+            armRetry(SessionClock::now());
+            return;
+        }
+
+        m_ctx.done = chunk.size() < m_block_size;
+
+        if (m_ctx.done or m_window_received >= m_window_size) {
+            sendAckMessage();
+        }
+    }
+
+    void Session::finishUpload() {
+        if (not m_upload->isFinished()) {
+            return;
+        }
+
+        m_store_pending = false;
+
+        if (m_upload->hasFailed()) {
+            sendError(MyTftp::ErrorCode::storage_issue, m_peer);
+            return;
+        }
+
+        m_ctx.done = true;
+        sendAckMessage();
+    }
+
+    void Session::sendError(MyTftp::ErrorCode error_code, const MyBSock::IOResult& target) {
+        /// NOTE: an unknown TID only concerns the stray sender, so the actual transfer carries on with its last reply intact.
+        const auto stray_sender = error_code == MyTftp::ErrorCode::unknown_tid;
+
+        /// NOTE: received slots get handled in order, so the first one is free again by the time any of them turns out to be stray.
+        if (stray_sender) {
+            sendErrorTo(m_socket, m_rx_slots.slots[0], error_code, target);
+        } else {
+            sendErrorTo(m_socket, m_tx_buffer, error_code, target);
+            m_ctx.done = true;
+        }
+
+        bumpCounter(m_resources.metrics->packets_out);
+        bumpCounter(m_resources.metrics->errors_sent[static_cast<std::size_t>(error_code)]);
+
+        logEvent<LogLevel::info>(makeLogOrigin(m_resources.worker_id, m_id, target.data), "sent error {}", static_cast<int>(error_code));
+    }
+
+    void Session::sendReply() {
+        m_socket.sendTo(m_tx_buffer, m_tx_buffer.getLength(), m_peer);
+        bumpCounter(m_resources.metrics->packets_out);
+        armRetry(SessionClock::now() + m_rto.getTimeout());
+    }
+
+    void Session::armRetry(SessionClock::time_point deadline) noexcept {
+        m_retry_deadline = deadline;
+        m_resources.timers->schedule(m_timer, deadline);
+    }
+
+    void Session::retransmit() {
+        bumpCounter(m_resources.metrics->retransmits);
+
+        /// NOTE: for RRQ every unacknowledged block of the window may be lost, so all of them go out again.
+        if (m_request_op == MyTftp::Opcode::rrq and m_sent_index > 0U) {
+            sendWindow(m_acked_index + 1U);
+        } else {
+            sendReply();
+        }
+
+        /// NOTE: Karn's rule: an answer to a re-sent reply may belong to either copy, so it yields no RTT sample.
+        m_rtt_probe.reset();
+    }
+
+    void Session::startRttProbe(std::uint64_t index) {
+        /// NOTE: like TCP, one round trip gets timed at once, so a pending probe is left running.
+        if (not m_rtt_probe.has_value()) {
+            m_rtt_probe = RttProbe {index, SessionClock::now()};
+        }
+    }
+
+    void Session::finishRttProbe(std::uint64_t index) {
+        if (m_rtt_probe.has_value() and index >= m_rtt_probe->index) {
+            const auto rtt = SessionClock::now() - m_rtt_probe->sent_at;
+
+            m_rto.addSample(rtt);
+            m_resources.metrics->ack_rtt.record(rtt);
+            m_rtt_probe.reset();
+        }
+    }
+
+    bool Session::hasSpaceFor(const std::string& filename, std::uintmax_t transfer_size) const {
+        std::error_code space_error;
+        const auto target_dir = std::filesystem::absolute(filename, space_error).parent_path();
+        const auto space_info = std::filesystem::space(target_dir, space_error);
+
+        /// NOTE: when free space is unknown, the upload is let through and a full disk shows up as a write error later.
+        return space_error or space_info.available >= transfer_size;
+    }
+
+    bool Session::prepareSlots() {
+        auto& pool = *m_resources.packet_pool;
+        auto rx_slots = makePacketSlots(pool, toRxSlotCount(m_request_op, m_window_size), toRxSlotSize(m_request_op, m_block_size));
+
+        if (not rx_slots.has_value()) {
+            return false;
+        }
+
+        m_rx_slots = rx_slots.value();
+
+        for (auto slot_index = 0UL; slot_index < m_rx_slots.count; slot_index++) {
+            if (not m_rx_batch.bindReceive(m_rx_slots.slots[slot_index])) {
+                return false;
+            }
+        }
+
+        if (m_mode == MyTftp::DataMode::netascii) {
+            auto ascii_slots = makePacketSlots(pool, 1UL, toAsciiSlotSize(m_block_size));
+
+            if (not ascii_slots.has_value()) {
+                return false;
+            }
+
+            m_ascii_slots = ascii_slots.value();
+        }
+
+        /// NOTE: a whole window gets queued at once, so the send buffer should hold one. Where `wmem_max` keeps it smaller, the tail waits for the socket to drain.
+        if (m_request_op == MyTftp::Opcode::rrq) {
+            static_cast<void>(MyBSock::reserveSendBuffer(m_socket.getFd(), m_window_size * (getBlockPacketSize() + udp_ipv4_overhead)));
+        }
+
+        /// NOTE: pre-encoded messages go out straight from the cache, so such a transfer needs no send slots.
+        if (m_request_op != MyTftp::Opcode::rrq or m_encoded != nullptr) {
+            return true;
+        }
+
+        auto tx_slots = makePacketSlots(pool, std::min(m_window_size, session_batch_size), MyTftp::data_header_size + m_block_size);
+
+        if (not tx_slots.has_value()) {
+            return false;
+        }
+
+        m_tx_slots = tx_slots.value();
+
+        /// NOTE: fixed reads target a registered buffer. When the ring's table is full, the session still uses the ring with plain reads.
+        if (m_resources.io_ring != nullptr) {
+            m_ring_buffer = m_resources.io_ring->registerBuffer(m_tx_slots.run.ptr, m_tx_slots.run.size);
+        }
+
+        return true;
+    }
+
+    Session::Session(unsigned int id, MyBSock::UDPServerSocket socket, const MyBSock::IOResult& peer, SessionResources& resources) noexcept
+    : m_ctx {{}, 0, false}, m_resources {resources}, m_cached {}, m_encoded {}, m_upload {}, m_rx_slots {{nullptr, 0, 0}, {}, 0}, m_tx_slots {{nullptr, 0, 0}, {}, 0}, m_ascii_slots {{nullptr, 0, 0}, {}, 0}, m_ascii_cursors {}, m_ascii_carry {}, m_rx_batch {}, m_tx_batch {}, m_tx_buffer {}, m_socket {std::move(socket)}, m_peer {peer}, m_group {}, m_members {}, m_started_at {SessionClock::now()}, m_retry_deadline {SessionClock::time_point::max()}, m_timer {this}, m_key {makePeerKey(peer.data)}, m_rto {}, m_rtt_probe {}, m_flow {(resources.scheduler != nullptr) ? resources.scheduler->makeFlow(peer.data) : SendFlow {}}, m_block_size {MyTftp::default_block_size}, m_window_size {MyTftp::min_window_size}, m_acked_index {0}, m_sent_index {0}, m_last_index {0}, m_pending_index {0}, m_pending_end {0}, m_file_size {}, m_ring_buffer {}, m_ring_linked {}, m_window_received {0}, m_request_op {MyTftp::Opcode::none}, m_mode {MyTftp::DataMode::octet}, m_id {id}, m_retries {0}, m_gap_reported {false}, m_resume_pending {false}, m_store_pending {false}, m_awaiting_writable {false} {}
+
+    Session::~Session() {
+        m_timer.cancel();
+
+        if (m_request_op == MyTftp::Opcode::rrq or m_request_op == MyTftp::Opcode::wrq) {
+            auto& durations = (m_request_op == MyTftp::Opcode::rrq) ? m_resources.metrics->rrq_durations : m_resources.metrics->wrq_durations;
+
+            durations.record(SessionClock::now() - m_started_at);
+        }
+
+        if (m_resources.scheduler != nullptr) {
+            m_resources.scheduler->cancel(m_flow);
+        }
+
+        if (m_group.has_value()) {
+            m_resources.multicast->release(m_group.value(), *this);
+        }
+
+        if (m_ring_buffer.has_value()) {
+            m_resources.io_ring->unregisterBuffer(m_ring_buffer.value());
+        }
+
+        for (const auto* slots : {&m_rx_slots, &m_tx_slots, &m_ascii_slots}) {
+            if (slots->run.ptr != nullptr) {
+                m_resources.packet_pool->release(slots->run);
+            }
+        }
+    }
+
+    unsigned int Session::getId() const noexcept {
+        return m_id;
+    }
+
+    int Session::getFd() const noexcept {
+        return m_socket.getFd();
+    }
+
+    const PeerKey& Session::getKey() const noexcept {
+        return m_key;
+    }
+
+    bool Session::isDone() const noexcept {
+        return m_ctx.done;
+    }
+
+    SendFlow& Session::getFlow() noexcept {
+        return m_flow;
+    }
+
+    bool Session::hasPendingBlocks() const noexcept {
+        return not m_ctx.done and m_pending_index < m_pending_end;
+    }
+
+    std::size_t Session::getBlockPacketSize() const noexcept {
+        return MyTftp::data_header_size + m_block_size;
+    }
+
+    std::size_t Session::sendPendingBlocks(std::size_t byte_budget) {
+        /// NOTE: the socket buffer is still full, so this turn passes, and the scheduler counts the session as stalled.
+        if (m_awaiting_writable) {
+            return 0UL;
+        }
+
+        const auto block_count = std::min<std::uint64_t>(byte_budget / getBlockPacketSize(), m_pending_end - m_pending_index);
+
+        if (block_count == 0U) {
+            return 0UL;
+        }
+
+        const auto sent_bytes = sendBlocks(m_pending_index, static_cast<std::size_t>(block_count));
+
+        /// NOTE: the short final block ends the window early, so nothing past it stays waiting. A full socket buffer may also cut the turn short, and the rest waits for the next one.
+        m_pending_index = (m_last_index != 0U and m_sent_index >= m_last_index) ? m_pending_end : m_sent_index + 1U;
+
+        return sent_bytes;
+    }
+
+    bool Session::addMember(const MyTftp::Message& request, const MyBSock::IOResult& peer) {
+        if (not m_group.has_value() or m_ctx.done) {
+            return false;
+        }
+
+        const auto peer_key = makePeerKey(peer.data);
+
+        /// NOTE: a repeated request means our OACK to that client got lost, so only the answer goes out again.
+        if (peer_key == makePeerKey(m_peer.data)) {
+            onRepeatedRequest();
+            return true;
+        }
+
+        auto member_it = findMember(peer_key);
+
+        if (member_it == m_members.end()) {
+            if (m_members.size() >= multicast_max_members) {
+                return false;
+            }
+
+            auto [negotiated, accepted] = MyTftp::negotiateOptions(std::get<MyTftp::RWPayload>(request.payload).options, {
+                .max_block_size = m_block_size,
+                .max_window_size = session_max_window,
+                .file_size = m_file_size,
+                .offer_tsize = true,
+                .echo_tsize = false,
+                .offer_multicast = true
+            });
+
+            /// NOTE: every member gets the same blocks, so a client which cannot take the transfer's block size reads on its own.
+            if (negotiated.block_size != m_block_size) {
+                return false;
+            }
+
+            /// NOTE: the retransmit timer belongs to the whole transfer, so a member's timeout is not honored.
+            std::erase_if(accepted, [](const MyTftp::OptionEntry& entry) {
+                return entry.name == MyTftp::option_name_timeout;
+            });
+
+            member_it = m_members.insert(m_members.end(), MulticastMember {peer, std::move(accepted), negotiated.window_size});
+            logEvent<LogLevel::info>(makeLogOrigin(m_resources.worker_id, m_id, peer.data), "joined multicast transfer, members={}", m_members.size());
+        }
+
+        sendMemberOAck(*member_it);
+        return true;
+    }
+
+    void Session::start(const MyTftp::Message& request) {
+        if (not m_socket.isUsable()) {
+            m_ctx.done = true;
+            return;
+        }
+
+        const auto& [filename, filemode, options] = std::get<MyTftp::RWPayload>(request.payload);
+
+        /// NOTE: a mode RFC 1350 does not define makes the request illegal, while `mail` is known but retired, so only the two file modes are served.
+        if (filemode == MyTftp::DataMode::dud) {
+            sendError(MyTftp::ErrorCode::bad_operation, m_peer);
+            return;
+        }
+
+        if (filemode != MyTftp::DataMode::octet and filemode != MyTftp::DataMode::netascii) {
+            sendError(MyTftp::ErrorCode::not_defined, m_peer);
+            return;
+        }
+
+        m_mode = filemode;
+
+        std::optional<std::uintmax_t> file_size;
+
+        if (request.op == MyTftp::Opcode::rrq) {
+            if (not openTransferFile(request.op, filename)) {
+                return;
+            }
+
+            if (const auto file_status = m_ctx.file.getStatus(); file_status.has_value()) {
+                file_size = static_cast<std::uintmax_t>(file_status->st_size);
+                m_file_size = static_cast<std::uint64_t>(file_status->st_size);
+            }
+
+            if (m_resources.file_cache != nullptr) {
+                m_cached = m_resources.file_cache->acquire(filename, m_ctx.file);
+            }
+        }
+
+        auto [negotiated, accepted] = MyTftp::negotiateOptions(options, {
+            .max_block_size = findBlockSizeLimit(),
+            .max_window_size = session_max_window,
+            .file_size = file_size,
+            .offer_tsize = request.op == MyTftp::Opcode::wrq or m_mode == MyTftp::DataMode::octet,
+            .echo_tsize = request.op == MyTftp::Opcode::wrq,
+            .offer_multicast = request.op == MyTftp::Opcode::rrq and m_mode == MyTftp::DataMode::octet and m_file_size.has_value() and m_resources.multicast != nullptr
+        });
+
+        /// NOTE: RFC 2349 lets the server refuse an upload it already knows will not fit.
+        if (request.op == MyTftp::Opcode::wrq and negotiated.transfer_size.has_value() and not hasSpaceFor(filename, negotiated.transfer_size.value())) {
+            sendError(MyTftp::ErrorCode::storage_issue, m_peer);
+            return;
+        }
+
+        if (request.op == MyTftp::Opcode::wrq and not openTransferFile(request.op, filename)) {
+            return;
+        }
+
+        m_request_op = request.op;
+        m_block_size = negotiated.block_size;
+        m_window_size = negotiated.window_size;
+
+        if (negotiated.timeout.has_value()) {
+            m_rto.pin(negotiated.timeout.value());
+        }
+
+        if (request.op == MyTftp::Opcode::rrq and m_mode == MyTftp::DataMode::octet and m_resources.packet_cache != nullptr) {
+            m_encoded = m_resources.packet_cache->acquire(filename, m_ctx.file, m_block_size);
+        }
+
+        /// NOTE: the worker's packet pool is capped, so a transfer beyond it gets refused up front instead of failing midway.
+        if (not prepareSlots()) {
+            sendError(MyTftp::ErrorCode::storage_issue, m_peer);
+            return;
+        }
+
+        /// NOTE: without a free group, the option is left out of the OACK, and per RFC 2090 the client then reads by unicast.
+        if (negotiated.multicast) {
+            m_group = m_resources.multicast->lease(filename, *this);
+
+            if (m_group.has_value() and not MyBSock::enableMulticastSend(m_socket.getFd(), m_resources.multicast->getInterface())) {
+                m_resources.multicast->release(m_group.value(), *this);
+                m_group.reset();
+            }
+        }
+
+        /// NOTE: members ACK the last block to leave, so its no. must be known before any block got read.
+        if (m_group.has_value()) {
+            m_last_index = m_file_size.value() / m_block_size + 1U;
+            accepted = addMulticastOption(std::move(accepted), true);
+        }
+
+        /// NOTE: an OACK stands in for the first reply: the RRQ peer answers it with ACK 0 and the WRQ peer with DATA 1.
+        if (not accepted.empty()) {
+            sendOAck(accepted);
+        } else if (request.op == MyTftp::Opcode::rrq) {
+            sendWindow(1U);
+        } else {
+            sendAckMessage();
+        }
+    }
+
+    void Session::onReadable() {
+        /// NOTE: drains the socket a batch at a time, so a burst of ACKs or a window of DATA costs one syscall instead of one per datagram.
+        while (not m_ctx.done and m_socket.recieveBatch(m_rx_batch) == MyBSock::IOStatus::ok) {
+            const auto filled_n = m_rx_batch.getFilled();
+
+            bumpCounter(m_resources.metrics->packets_in, filled_n);
+
+            for (auto slot_index = 0UL; slot_index < filled_n and not m_ctx.done; slot_index++) {
+                auto& slot = m_rx_slots.slots[slot_index];
+                const auto io_result = m_rx_batch.getPeer(slot_index);
+
+                slot.markLength(m_rx_batch.getLength(slot_index));
+
+                /// NOTE: validate transfer ID of peer's sending address... RFC 1350 states an invalid TID may denote an incorrectly sent message.
+                if (makePeerKey(io_result.data) != makePeerKey(m_peer.data)) {
+                    if (not m_group.has_value() or not handleMemberMessage(MyTftp::parseMessageView(slot), io_result)) {
+                        sendError(MyTftp::ErrorCode::unknown_tid, io_result);
+                    }
+
+                    continue;
+                }
+
+                m_retries = 0;
+                handleMessage(MyTftp::parseMessageView(slot), io_result);
+            }
+
+            if (filled_n < m_rx_batch.getCount()) {
+                break;
+            }
+        }
+
+        if (m_resume_pending and not m_ctx.done) {
+            sendWindow(m_acked_index + 1U);
+        }
+
+        m_resume_pending = false;
+    }
+
+    void Session::onWritable() {
+        if (m_tx_batch.getUnsent() > 0UL) {
+            pushBatch();
+        } else {
+            watchWritable(false);
+        }
+    }
+
+    void Session::onRepeatedRequest() {
+        if (m_ctx.done or m_store_pending or (m_tx_buffer.isEmpty() and m_sent_index == 0U)) {
+            return;
+        }
+
+        retransmit();
+    }
+
+    void Session::onTick(SessionClock::time_point now) {
+        if (m_store_pending) {
+            finishUpload();
+
+            if (m_store_pending) {
+                armRetry(now);
+            }
+
+            return;
+        }
+
+        /// NOTE: blocks still waiting for their turn were never sent, so the peer's silence says nothing yet. Sending them re-arms the timer.
+        if (m_ctx.done or hasPendingBlocks()) {
+            return;
+        }
+
+        if (now < m_retry_deadline) {
+            armRetry(m_retry_deadline);
+            return;
+        }
+
+        if (++m_retries > session_max_retries) {
+            logEvent<LogLevel::warn>(makeLogOrigin(m_resources.worker_id, m_id, m_peer.data), "timed out after {} retries, srtt={}us", session_max_retries, std::chrono::duration_cast<std::chrono::microseconds>(m_rto.getSmoothedRtt()).count());
+
+            /// NOTE: a silent multicast master only drops out itself, and the next member carries the transfer on.
+            if (m_group.has_value()) {
+                promoteNextMember();
+            } else {
+                m_ctx.done = true;
+            }
+
+            return;
+        }
+
+        /// NOTE: a silent peer may sit behind a congested or slower path than estimated, so each timeout doubles the RTO before re-sending.
+        m_rto.backOff();
+        retransmit();
+    }
+}
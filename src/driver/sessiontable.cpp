@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <bit>
+#include <utility>
+#include "driver/sessiontable.hpp"
+
+namespace TftpServer::Driver {
+    /// NOTE: at most half the slots get used, which keeps linear probe runs to a couple of records on average.
+    static constexpr auto table_load_divisor = 2UL;
+
+    SessionTable::SessionTable(std::size_t max_entries)
+    : m_records {}, m_mask {0UL}, m_count {0UL} {
+        const auto slot_count = std::bit_ceil(std::max(max_entries, 1UL) * table_load_divisor);
+
+        m_records.resize(slot_count);
+        m_mask = slot_count - 1UL;
+    }
+
+    std::size_t SessionTable::toHome(const PeerKey& key) const noexcept {
+        return PeerKeyHash {}(key) & m_mask;
+    }
+
+    std::size_t SessionTable::findIndex(const PeerKey& key) const noexcept {
+        for (auto index = toHome(key); m_records[index].session != nullptr; index = (index + 1UL) & m_mask) {
+            if (m_records[index].key == key) {
+                return index;
+            }
+        }
+
+        return m_records.size();
+    }
+
+    void SessionTable::eraseAt(std::size_t index) noexcept {
+        m_records[index].session.reset();
+        m_count--;
+
+        auto hole = index;
+
+        /// NOTE: a later record of the run may fill the hole only if its home slot does not lie between the hole and itself, or lookups would stop at the hole before reaching it.
+        for (auto next = (hole + 1UL) & m_mask; m_records[next].session != nullptr; next = (next + 1UL) & m_mask) {
+            const auto home_distance = (next - toHome(m_records[next].key)) & m_mask;
+            const auto hole_distance = (next - hole) & m_mask;
+
+            if (home_distance >= hole_distance) {
+                m_records[hole] = std::move(m_records[next]);
+                hole = next;
+            }
+        }
+    }
+
+    std::size_t SessionTable::getSize() const noexcept {
+        return m_count;
+    }
+
+    bool SessionTable::isEmpty() const noexcept {
+        return m_count == 0UL;
+    }
+
+    Session* SessionTable::find(const PeerKey& key) const noexcept {
+        const auto index = findIndex(key);
+
+        return (index < m_records.size()) ? m_records[index].session.get() : nullptr;
+    }
+
+    bool SessionTable::insert(const PeerKey& key, Handle session) {
+        if (m_count + 1UL >= m_records.size() or findIndex(key) < m_records.size()) {
+            return false;
+        }
+
+        auto index = toHome(key);
+
+        while (m_records[index].session != nullptr) {
+            index = (index + 1UL) & m_mask;
+        }
+
+        m_records[index] = Record {key, std::move(session)};
+        m_count++;
+
+        return true;
+    }
+
+    bool SessionTable::erase(const PeerKey& key) noexcept {
+        const auto index = findIndex(key);
+
+        if (index == m_records.size()) {
+            return false;
+        }
+
+        eraseAt(index);
+
+        return true;
+    }
+}
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include "driver/timerwheel.hpp"
+
+namespace TftpServer::Driver {
+    static constexpr auto wheel_tick = std::chrono::duration_cast<TimerClock::duration>(rto_granularity);
+    static constexpr auto max_wheel_delta = (1UL << (timer_wheel_levels * timer_wheel_bits)) - 1UL;
+
+    TimerNode::TimerNode() noexcept
+    : TimerNode {nullptr} {}
+
+    TimerNode::TimerNode(Session* owner) noexcept
+    : prev {this}, next {this}, session {owner}, expiry {0UL} {}
+
+    void TimerNode::cancel() noexcept {
+        prev->next = next;
+        next->prev = prev;
+        prev = this;
+        next = this;
+    }
+
+    TimerWheel::TimerWheel()
+    : m_slots {}, m_origin {TimerClock::now()}, m_current_tick {0UL} {}
+
+    std::uint64_t TimerWheel::toTicks(TimerClock::time_point when, bool round_up) const noexcept {
+        if (when <= m_origin) {
+            return 0UL;
+        }
+
+        const auto elapsed = when - m_origin;
+        const auto whole_ticks = static_cast<std::uint64_t>(elapsed / wheel_tick);
+
+        return (round_up and elapsed % wheel_tick != TimerClock::duration::zero()) ? whole_ticks + 1UL : whole_ticks;
+    }
+
+    bool TimerWheel::isEmpty() const noexcept {
+        return std::ranges::all_of(m_slots, [](const auto& level_slots) {
+            return std::ranges::all_of(level_slots, [](const TimerNode& head) {
+                return head.next == &head;
+            });
+        });
+    }
+
+    void TimerWheel::place(TimerNode& node) noexcept {
+        const auto delta = std::min(node.expiry - m_current_tick, max_wheel_delta);
+        const auto slot_tick = m_current_tick + delta;
+        auto level = 0UL;
+
+        while (level + 1UL < timer_wheel_levels and delta >= (1UL << ((level + 1UL) * timer_wheel_bits))) {
+            level++;
+        }
+
+        auto& head = m_slots[level][(slot_tick >> (level * timer_wheel_bits)) & (timer_wheel_slots - 1UL)];
+
+        node.prev = head.prev;
+        node.next = &head;
+        head.prev->next = &node;
+        head.prev = &node;
+    }
+
+    void TimerWheel::cascade(std::size_t level) noexcept {
+        auto& head = m_slots[level][(m_current_tick >> (level * timer_wheel_bits)) & (timer_wheel_slots - 1UL)];
+
+        if (head.next == &head) {
+            return;
+        }
+
+        /// NOTE: the slot's list gets detached first, since a timer still out of range lands in the same slot again.
+        TimerNode pending {};
+
+        pending.next = head.next;
+        pending.prev = head.prev;
+        pending.next->prev = &pending;
+        pending.prev->next = &pending;
+        head.next = &head;
+        head.prev = &head;
+
+        while (pending.next != &pending) {
+            auto& node = *pending.next;
+
+            node.cancel();
+            place(node);
+        }
+    }
+
+    void TimerWheel::catchUp(TimerClock::time_point now) noexcept {
+        if (const auto now_tick = toTicks(now, false); now_tick > m_current_tick and isEmpty()) {
+            m_current_tick = now_tick;
+        }
+    }
+
+    void TimerWheel::schedule(TimerNode& node, TimerClock::time_point deadline) noexcept {
+        node.cancel();
+        node.expiry = std::max(toTicks(deadline, true), m_current_tick + 1UL);
+        place(node);
+    }
+}
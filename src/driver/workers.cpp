@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include "driver/workers.hpp"
+
+namespace TftpServer::Driver {
+    [[nodiscard]] static bool pinCurrentThread(std::size_t core) noexcept {
+        const auto core_count = std::max(std::thread::hardware_concurrency(), 1U);
+        cpu_set_t core_set;
+
+        CPU_ZERO(&core_set);
+        CPU_SET(core % core_count, &core_set);
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(core_set), &core_set) == 0;
+    }
+
+    WorkerGroup::WorkerGroup(const ServerConfig& config, const SessionResources& resources, MetricsRegistry& metrics)
+    : m_servers {}, m_first_core {config.first_core} {
+        /// NOTE: a lone worker keeps the port exclusive, so a second server started by mistake fails to bind, and exits with the reason, instead of silently taking half the peers.
+        const auto reuse_port = config.worker_count > 1UL;
+
+        m_servers.reserve(config.worker_count);
+
+        for (auto worker_index = 0UL; worker_index < config.worker_count; worker_index++) {
+            auto worker_resources = resources;
+            worker_resources.metrics = &metrics.getWorker(worker_index);
+
+            auto listener = makeUDPSocket(config.port_cstr, reuse_port);
+
+            if (not listener.isUsable()) {
+                throw std::runtime_error {std::format("could not bind UDP port {}: {}", config.port_cstr, std::strerror(errno))};
+            }
+
+            m_servers.emplace_back(std::make_unique<MyServer>(std::move(listener), worker_resources, static_cast<unsigned int>(worker_index), config));
+        }
+    }
+
+    bool WorkerGroup::runWorker(std::size_t worker_index) {
+        if (m_first_core.has_value() and not pinCurrentThread(m_first_core.value() + worker_index)) {
+            logEvent<LogLevel::warn>({static_cast<unsigned int>(worker_index), 0U, 0, 0}, "could not be pinned, running unpinned");
+        }
+
+        if (not m_servers[worker_index]->runService()) {
+            /// NOTE: one broken shard would leave its share of peers unanswered, so the whole group shuts down.
+            requestStop();
+            return false;
+        }
+
+        return true;
+    }
+
+    void WorkerGroup::requestStop() const noexcept {
+        for (const auto& server : m_servers) {
+            server->requestStop();
+        }
+    }
+
+    bool WorkerGroup::runService() {
+        std::atomic<bool> all_ok {true};
+
+        {
+            std::vector<std::jthread> threads;
+            threads.reserve(m_servers.size());
+
+            /// NOTE: the calling thread runs worker 0, so a single worker needs no extra thread.
+            for (auto worker_index = 1UL; worker_index < m_servers.size(); worker_index++) {
+                threads.emplace_back([this, &all_ok, worker_index] {
+                    if (not runWorker(worker_index)) {
+                        all_ok.store(false, std::memory_order_relaxed);
+                    }
+                });
+            }
+
+            if (not runWorker(0UL)) {
+                all_ok.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        return all_ok.load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+#include "driver/writer.hpp"
+
+namespace TftpServer::Driver {
+    void WriteChunkDeleter::operator()(unsigned char* ptr) const noexcept {
+        ::operator delete[](ptr, std::align_val_t {write_chunk_align});
+    }
+
+    FileWriter::FileWriter(std::size_t capacity)
+    : m_tasks {}, m_free_chunks {}, m_mutex {}, m_wakeup {}, m_chunk_limit {std::max(capacity / write_chunk_size, 1UL)}, m_chunks_made {0}, m_thread {} {
+        /// NOTE: the free list gets room for every chunk up front, so recycling one never allocates.
+        m_free_chunks.reserve(m_chunk_limit);
+        m_thread = std::jthread {[this](std::stop_token stop_token) {
+            runWriter(stop_token);
+        }};
+    }
+
+    void FileWriter::runWriter(std::stop_token stop_token) {
+        std::unique_lock lock {m_mutex};
+
+        /// NOTE: a stop only ends the thread once the queue is empty, so every accepted upload still reaches the disk on shutdown.
+        while (true) {
+            m_wakeup.wait(lock, stop_token, [this] {
+                return not m_tasks.empty();
+            });
+
+            if (m_tasks.empty()) {
+                break;
+            }
+
+            auto task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+
+            lock.unlock();
+            runTask(task);
+            lock.lock();
+
+            if (task.chunk != nullptr) {
+                m_free_chunks.push_back(std::move(task.chunk));
+            }
+        }
+    }
+
+    void FileWriter::runTask(WriteTask& task) noexcept {
+        auto& job = *task.job;
+
+        if (task.chunk != nullptr) {
+            if (not job.failed.load(std::memory_order_relaxed) and not job.file.writeAt(task.chunk.get(), task.length, task.offset)) {
+                job.failed.store(true, std::memory_order_relaxed);
+            }
+
+            return;
+        }
+
+        if (not job.failed.load(std::memory_order_relaxed) and not job.file.sync()) {
+            job.failed.store(true, std::memory_order_relaxed);
+        }
+
+        job.file.close();
+        job.finished.store(true, std::memory_order_release);
+    }
+
+    WriteChunk FileWriter::tryAcquireChunk() noexcept {
+        std::lock_guard guard {m_mutex};
+
+        if (not m_free_chunks.empty()) {
+            auto temp = std::move(m_free_chunks.back());
+            m_free_chunks.pop_back();
+
+            return temp;
+        }
+
+        if (m_chunks_made >= m_chunk_limit) {
+            return {};
+        }
+
+        auto* chunk_ptr = static_cast<unsigned char*>(::operator new[](write_chunk_size, std::align_val_t {write_chunk_align}, std::nothrow));
+
+        m_chunks_made += (chunk_ptr != nullptr) ? 1UL : 0UL;
+
+        return WriteChunk {chunk_ptr};
+    }
+
+    void FileWriter::recycle(WriteChunk chunk) noexcept {
+        std::lock_guard guard {m_mutex};
+
+        m_free_chunks.push_back(std::move(chunk));
+    }
+
+    void FileWriter::submit(const std::shared_ptr<UploadJob>& job, WriteChunk chunk, std::size_t length, std::uint64_t offset) {
+        {
+            std::lock_guard guard {m_mutex};
+            m_tasks.push_back({job, std::move(chunk), length, offset});
+        }
+
+        m_wakeup.notify_one();
+    }
+
+    void FileWriter::submitFinish(const std::shared_ptr<UploadJob>& job) {
+        {
+            std::lock_guard guard {m_mutex};
+            m_tasks.push_back({job, {}, 0UL, 0UL});
+        }
+
+        m_wakeup.notify_one();
+    }
+
+    UploadStream::UploadStream(FileWriter& writer, FileHandle file)
+    : m_writer {writer}, m_job {std::make_shared<UploadJob>(std::move(file), false, false)}, m_chunk {}, m_chunk_offset {0}, m_chunk_fill {0}, m_chunk_room {0}, m_offset {0} {}
+
+    UploadStream::~UploadStream() {
+        if (m_chunk != nullptr) {
+            m_writer.recycle(std::move(m_chunk));
+        }
+    }
+
+    void UploadStream::flushChunk() {
+        if (m_chunk_fill > 0UL) {
+            m_writer.submit(m_job, std::move(m_chunk), m_chunk_fill, m_chunk_offset);
+        } else if (m_chunk != nullptr) {
+            m_writer.recycle(std::move(m_chunk));
+        }
+
+        m_chunk = nullptr;
+        m_chunk_fill = 0;
+    }
+
+    bool UploadStream::append(const unsigned char* source, std::size_t length) {
+        auto done_n = 0UL;
+
+        if (m_job->failed.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        while (done_n < length) {
+            if (m_chunk == nullptr) {
+                m_chunk = m_writer.tryAcquireChunk();
+
+                if (m_chunk == nullptr) {
+                    /// NOTE: writes are positional, so this can land while earlier chunks of the file are still queued.
+                    if (not m_job->file.writeAt(source + done_n, length - done_n, m_offset)) {
+                        m_job->failed.store(true, std::memory_order_relaxed);
+                        return false;
+                    }
+
+                    m_offset += length - done_n;
+                    return true;
+                }
+
+                /// NOTE: a chunk staged after inline writes only runs up to the next aligned offset, so the ones after it are aligned again.
+                m_chunk_offset = m_offset;
+                m_chunk_room = write_chunk_size - static_cast<std::size_t>(m_offset % write_chunk_size);
+            }
+
+            const auto part_n = std::min(length - done_n, m_chunk_room - m_chunk_fill);
+
+            std::memcpy(m_chunk.get() + m_chunk_fill, source + done_n, part_n);
+            m_chunk_fill += part_n;
+            m_offset += part_n;
+            done_n += part_n;
+
+            if (m_chunk_fill == m_chunk_room) {
+                flushChunk();
+            }
+        }
+
+        return true;
+    }
+
+    void UploadStream::finish() {
+        flushChunk();
+        m_writer.submitFinish(m_job);
+    }
+
+    bool UploadStream::isFinished() const noexcept {
+        return m_job->finished.load(std::memory_order_acquire);
+    }
+
+    bool UploadStream::hasFailed() const noexcept {
+        return m_job->failed.load(std::memory_order_relaxed);
+    }
+}
@@ -5,379 +5,144 @@
  * @date 2/05/2025
  */
 
-// TODO: implement driver.
-
-#include <array>
-#include <string>
-#include <atomic>
-#include <thread>
-#include <fstream>
+#include <csignal>
 #include <iostream>
-#include <print>
-#include "mybsock/netconfig.hpp"
-#include "mybsock/buffers.hpp"
-#include "mybsock/sockets.hpp"
-#include "mytftp/types.hpp"
-#include "mytftp/messaging.hpp"
-
-static constexpr auto expected_argc = 2;
-
-namespace TftpServer::Driver {
-    static constexpr MyTftp::tftp_u16 dud_peer_tid = 0;
-    static constexpr auto min_free_port = 1024;
-    static constexpr auto tftp_chunk_size = 512UL;
-    static constexpr auto io_buffer_size = 1024UL;
-
-    static const std::array<std::string, static_cast<std::size_t>(MyTftp::ErrorCode::last) + 1> server_error_msgs = {
-        "OK!",
-        "Internal server error: reply corrupted / bad request args.",
-        "File not found.",
-        "File access violation.",
-        "Disk full or allocation exceeded.",
-        "Invalid operation.",
-        "Unknown transfer ID.",
-        "File already exists.",
-        "No such user.",
-    };
-
-    [[nodiscard]] MyBSock::UDPServerSocket makeUDPSocket(const char* port_cstr);
-
-    struct TransferContext {
-        std::fstream fs;
-        MyTftp::tftp_u16 block;
-        bool done;
-    };
-
-    struct ReadResult {
-        MyTftp::Message msg;
-        MyBSock::IOResult io_data;
-    };
-
-    class MyServer {
-    private:
-        TransferContext m_ctx;  // stores transfer session state
-        MyBSock::FixedBuffer<MyTftp::tftp_u8, io_buffer_size> m_buffer;
-        MyBSock::UDPServerSocket m_socket;  // for underlying UDP for TFTP messaging
-        MyTftp::tftp_u16 m_peer_tid;    // tracks current peer of current transfer
-        std::atomic_flag m_persist;
-
-        [[nodiscard]] std::u8string readNextFileChunk();
-        [[nodiscard]] bool writeNextFileChunk(const std::u8string& blob);
-
-        [[nodiscard]] ReadResult readMessage();
-        void handleMessage(const ReadResult& read_result);
-        void sendDataMessage(MyTftp::Opcode op, const MyTftp::Message& previous, const MyBSock::IOResult& prev_io);
-        void sendAck(MyTftp::Opcode op, const MyTftp::Message& previous, const MyBSock::IOResult& prev_io);
-        void sendError(MyTftp::ErrorCode error_code, const MyBSock::IOResult& prev_io);
-
-    public:
-        MyServer() = delete;
-        MyServer(MyBSock::UDPServerSocket socket) noexcept;
-
-        [[nodiscard]] bool runService();
-    };
-
-
-    MyBSock::UDPServerSocket makeUDPSocket(const char* port_cstr) {
-        MyBSock::SocketGenerator sockgen {port_cstr};
-
-        while (sockgen) {
-            auto fd_optional = sockgen();
-
-            if (fd_optional.has_value()) {
-                return {fd_optional.value()};
-            }
-        }
-
-        return {};
+#include <optional>
+#include <stdexcept>
+#include <unistd.h>
+#include "driver/config.hpp"
+#include "driver/filecache.hpp"
+#include "driver/logging.hpp"
+#include "driver/metrics.hpp"
+#include "driver/packetcache.hpp"
+#include "driver/prewarm.hpp"
+#include "driver/workers.hpp"
+#include "driver/writer.hpp"
+
+static TftpServer::Driver::WorkerGroup* running_workers = nullptr;
+
+extern "C" void handleStopSignal([[maybe_unused]] int signal_id) {
+    if (running_workers != nullptr) {
+        running_workers->requestStop();
     }
+}
 
-    std::u8string MyServer::readNextFileChunk() {
-        auto pending_rc = tftp_chunk_size;
+static void installStopHandlers() {
+    struct sigaction stop_action {};
+    stop_action.sa_handler = handleStopSignal;
+    sigemptyset(&stop_action.sa_mask);
 
-        std::u8string result;
+    sigaction(SIGINT, &stop_action, nullptr);
+    sigaction(SIGTERM, &stop_action, nullptr);
+}
 
-        while (pending_rc > 0 and not m_ctx.fs.eof()) {
-            result += static_cast<MyTftp::tftp_u8>(m_ctx.fs.get());
+static void printCacheStats(const TftpServer::Driver::FileCache& cache) {
+    const auto [block_hits, block_misses, bytes_served, bytes_resident, evictions, files] = cache.getStats();
+    const auto block_reads = block_hits + block_misses;
+    const auto hit_ratio = (block_reads > 0) ? static_cast<double>(block_hits) / static_cast<double>(block_reads) : 0.0;
 
-            pending_rc--;
-        }
+    using namespace TftpServer::Driver;
 
-        return result;
-    }
+    logEvent<LogLevel::info>({log_no_worker, 0U, 0, 0}, "cache hit-ratio={:.3f}, hits={}, misses={}, bytes-served={}, resident={}B in {} files, evictions={}", hit_ratio, block_hits, block_misses, bytes_served, bytes_resident, files, evictions);
+}
 
-    bool MyServer::writeNextFileChunk(const std::u8string& blob) {
-        if (m_ctx.fs.bad()) {
-            return false;
-        }
+static void printPacketCacheStats(const TftpServer::Driver::PacketCache& cache) {
+    const auto [hits, misses, builds, bytes_resident, evictions, files] = cache.getStats();
 
-        for (const auto octet : blob) {
-            if (m_ctx.fs.put(octet).bad()) {
-                return false;
-            }
-        }
+    using namespace TftpServer::Driver;
 
-        return true;
-    }
+    logEvent<LogLevel::info>({log_no_worker, 0U, 0, 0}, "packet cache hits={}, misses={}, builds={}, resident={}B in {} files, evictions={}", hits, misses, builds, bytes_resident, files, evictions);
+}
 
-    ReadResult MyServer::readMessage() {
-        m_buffer.reset();
+static void prewarmCache(const TftpServer::Driver::ServerConfig& config, TftpServer::Driver::FileCache& cache) {
+    using namespace TftpServer::Driver;
 
-        auto io_result = m_socket.recieveFrom(m_buffer, io_buffer_size);
+    const auto report = prewarmFiles(config.prewarm_path, cache, config.cache_bytes, config.prewarm_lock_bytes);
 
-        return {
-            MyTftp::parseMessage(m_buffer),
-            io_result
-        };
+    /// NOTE: warming only speeds up the first requests, so the server still starts without it.
+    if (not report.has_value()) {
+        logEvent<LogLevel::warn>({log_no_worker, 0U, 0, 0}, "prewarm skipped, cannot read manifest {}", config.prewarm_path);
+        return;
     }
 
-    void MyServer::handleMessage(const ReadResult& read_result) {
-        m_buffer.reset();
+    const auto [files, cached_files, locked_files, failed_files, bytes_read, bytes_locked, elapsed] = report.value();
 
-        const auto& [msg, io_result] = read_result;
-
-        const auto peer_tid = io_result.data.sin_port;
+    logEvent<LogLevel::info>({log_no_worker, 0U, 0, 0}, "prewarm done in {}ms: {} files, {}B read, {} cached, {} locked ({}B), {} failed", elapsed.count(), files, bytes_read, cached_files, locked_files, bytes_locked, failed_files);
+}
 
-        /// NOTE: validate transfer ID of peer's sending port number... RFC 1350 states an invalid TID may denote an incorrectly sent message. 
-        if (peer_tid != m_peer_tid and m_peer_tid != dud_peer_tid) {
-            sendError(MyTftp::ErrorCode::unknown_tid, io_result);
-            return;
-        } else if (m_peer_tid == dud_peer_tid) {
-            std::print("tftpd [LOG]: saved peer-tid\n");
-            m_peer_tid = peer_tid;
-        }
+int main(int argc, char* argv[]) {
+    using namespace TftpServer;
 
-        const auto opcode = msg.op;
-        std::print("tftpd [LOG]: opcode={}\n", static_cast<int>(opcode));
-
-        switch (opcode) {
-        case MyTftp::Opcode::rrq:
-            sendDataMessage(opcode, msg, io_result);
-            break;
-        case MyTftp::Opcode::wrq:
-        case MyTftp::Opcode::data:
-            sendAck(opcode, msg, io_result);
-            break;
-        case MyTftp::Opcode::ack:
-            sendDataMessage(opcode, msg, io_result);
-            break;
-        case MyTftp::Opcode::err:
-            break;
-        default:
-            sendError(MyTftp::ErrorCode::bad_operation, io_result);
-            break;
-        }
+    const auto config = Driver::parseConfig(argc, argv);
 
-        /// NOTE: Prepare to service a new peer by TID after the transfer finishes. The peer could be the same or different.
-        if (m_ctx.done) {
-            m_ctx.fs = {};
-            m_ctx.block = 0;
-            m_ctx.done = false;
-            m_peer_tid = dud_peer_tid;
-        }
+    if (not config.has_value()) {
+        std::cerr << "Invalid arguments.\nusage: ./tftpd <port no. above 1024> [--cache-mb <n>] [--packet-cache-mb <n>] [--prewarm <manifest>] [--prewarm-lock-mb <n>] [--workers <n>] [--pin-cores <first core>] [--io-backend epoll|uring] [--max-sessions <n>] [--pool-mb <n>] [--huge-pages on|off] [--write-behind-mb <n>] [--metrics-file <path>] [--rate-mbit <n>] [--session-rate-mbit <n>] [--rate-class <ipv4>/<prefix>=<mbit>]... [--multicast <group ipv4>:<port>] [--multicast-if <ipv4>]\n";
+        return 1;
     }
 
-    void MyServer::sendDataMessage(MyTftp::Opcode op, const MyTftp::Message& previous, const MyBSock::IOResult& prev_io) {
-        if (op == MyTftp::Opcode::rrq) {
-            const auto [filename, filemode] = std::get<MyTftp::RWPayload>(previous.payload);
-
-            if (filemode != MyTftp::DataMode::octet) {
-                sendError(MyTftp::ErrorCode::not_defined, prev_io);
-                return;
-            }
-
-            std::fstream temp_fs {filename, std::fstream::binary | std::fstream::in};
-
-            if (not temp_fs.is_open()) {
-                sendError(MyTftp::ErrorCode::file_not_found, prev_io);
-                return;
-            }
-
-            m_ctx.fs = std::move(temp_fs),
-            m_ctx.block = 1;
-            m_ctx.done = false;
-
-            auto chunk_blob = readNextFileChunk();
-            const auto at_last_chunk = chunk_blob.size() < tftp_chunk_size;
-            const auto data_msg_ok = MyTftp::serializeMessage(m_buffer, MyTftp::Message {
-                MyTftp::Opcode::data,
-                MyTftp::DataPayload {
-                    .data = std::move(chunk_blob),
-                    .block_n = m_ctx.block
-                }
-            });
-
-            if (not data_msg_ok) {
-                sendError(MyTftp::ErrorCode::not_defined, prev_io);
-                return;
-            }
-
-            m_ctx.done = at_last_chunk;
-            m_socket.sendTo(m_buffer, m_buffer.getLength(), prev_io);
-        } else {
-            // 2. for ACK
-            if (m_ctx.done) {
-                return;
-            }
-
-            const auto [prev_block_n] = std::get<MyTftp::AckPayload>(previous.payload);
-
-            const auto next_block_n = prev_block_n + 1U;
-
-            auto next_chunk_blob = readNextFileChunk();
-            const auto at_ending_chunk = next_chunk_blob.size() < tftp_chunk_size;
-            const auto next_data_ok = MyTftp::serializeMessage(m_buffer, MyTftp::Message {
-                MyTftp::Opcode::data,
-                MyTftp::DataPayload {
-                    .data = std::move(next_chunk_blob),
-                    .block_n = next_block_n
-                }
-            });
-
-            if (not next_data_ok) {
-                sendError(MyTftp::ErrorCode::not_defined, prev_io);
-                return;
-            }
-
-            m_ctx.block = next_block_n;
-            m_ctx.done = at_ending_chunk;
-            m_socket.sendTo(m_buffer, m_buffer.getLength(), prev_io);
-        }
-    }
+    try {
+        /// NOTE: constructed first, so it outlives every thread which logs.
+        Driver::AsyncLogger logger {STDOUT_FILENO};
+        Driver::setActiveLogger(&logger);
 
-    void MyServer::sendAck(MyTftp::Opcode op, const MyTftp::Message& previous, const MyBSock::IOResult& prev_io) {
-        if (op == MyTftp::Opcode::wrq) {
-            const auto [filename, filemode] = std::get<MyTftp::RWPayload>(previous.payload);
-
-            if (filemode != MyTftp::DataMode::octet) {
-                sendError(MyTftp::ErrorCode::not_defined, prev_io);
-                return;
-            }
-
-            std::fstream temp_fs {filename, std::fstream::binary | std::fstream::out};
-
-            if (not temp_fs.is_open()) {
-                sendError(MyTftp::ErrorCode::access_violation, prev_io);
-                return;
-            }
-
-            m_ctx.fs = std::move(temp_fs),
-            m_ctx.block = 0;
-            m_ctx.done = false;
-
-            if (not MyTftp::serializeMessage(m_buffer, MyTftp::Message {
-                MyTftp::Opcode::ack,
-                MyTftp::AckPayload {
-                    m_ctx.block
-                }
-            })) {
-                sendError(MyTftp::ErrorCode::not_defined, prev_io);
-                return;
-            }
-
-            m_socket.sendTo(m_buffer, m_buffer.getLength(), prev_io);
-        } else {
-            const auto [block_n, chunk] = std::get<MyTftp::DataPayload>(previous.payload);
-
-            /// NOTE: validate block num. to check chunk ordering... a mis-ordered chunk would result in the wrong file contents!
-            if (const auto prev_block_n = m_ctx.block; block_n - 1 != prev_block_n) {
-                sendError(MyTftp::ErrorCode::not_defined, prev_io);
-                return;
-            }
-
-            if (not writeNextFileChunk(chunk)) {
-                sendError(MyTftp::ErrorCode::storage_issue, prev_io);
-                return;
-            }
-
-            // 2. for DATA msg
-            if (MyTftp::serializeMessage(m_buffer, MyTftp::Message {
-                MyTftp::Opcode::ack,
-                MyTftp::AckPayload {
-                    block_n
-                }
-            })) {
-                m_socket.sendTo(m_buffer, m_buffer.getLength(), prev_io);
-                m_ctx.block++;
-            }
-
-            m_ctx.done = chunk.size() < tftp_chunk_size;
-        }
-    }
+        Driver::FileCache file_cache {config->cache_bytes};
 
-    void MyServer::sendError(MyTftp::ErrorCode error_code, const MyBSock::IOResult& prev_io) {
-        const auto error_msg_id = static_cast<MyTftp::tftp_u16>(error_code);
-        const auto& error_msg = server_error_msgs[error_msg_id];
-
-        if (MyTftp::serializeMessage(m_buffer, MyTftp::Message {
-            MyTftp::Opcode::err,
-            MyTftp::ErrorPayload {
-                .error = error_code,
-                .message = error_msg
-            }
-        })) {
-            m_socket.sendTo(m_buffer, m_buffer.getLength(), prev_io);
+        /// NOTE: runs before the workers bind their sockets, so no request ever meets a cold cache.
+        if (config->prewarm_path != nullptr) {
+            prewarmCache(config.value(), file_cache);
         }
 
-        std::print("tftpd [LOG]: attempted to send error {} to peer with port {}\n", static_cast<int>(error_code), prev_io.data.sin_port);
-        m_ctx.done = true;
-    }
-
-    MyServer::MyServer(MyBSock::UDPServerSocket socket) noexcept
-    : m_ctx {{}, 0, true}, m_buffer {}, m_socket {std::move(socket)}, m_peer_tid {dud_peer_tid}, m_persist {true} {}
+        std::optional<Driver::PacketCache> packet_cache;
 
-    bool MyServer::runService() {
-        if (not m_socket.isUsable()) {
-            return false;
+        if (config->packet_cache_bytes > 0UL) {
+            packet_cache.emplace(config->packet_cache_bytes);
         }
 
-        auto user_control_fn = [this]() {
-            char stop_choice = 'n';
-
-            do {
-                std::cout << "Enter 'y' to stop.\n";
-                std::cin >> stop_choice;
-            } while (stop_choice != 'y');
-
-            m_persist.clear();
-            std::cout << "Please wait...\n";
-        };
-
-        std::thread control_thread {user_control_fn};
+        Driver::MetricsRegistry metrics {config->worker_count, &file_cache, packet_cache.has_value() ? &packet_cache.value() : nullptr};
+        std::optional<Driver::MetricsExporter> metrics_exporter;
 
-        while (m_persist.test()) {
-            const auto recieve_result = readMessage();
-
-            std::print("tftpd [LOG]: recieve of IOStatus={}, peer-port={}\n", static_cast<int>(recieve_result.io_data.status), recieve_result.io_data.data.sin_port);
-
-            handleMessage(recieve_result);
-            std::print("tftpd [LOG]: replied; peer-tid={}, ctx-block-n={}, ctx-done={}\n", m_peer_tid, m_ctx.block, m_ctx.done);
+        if (config->metrics_path != nullptr) {
+            metrics_exporter.emplace(config->metrics_path, metrics);
         }
 
-        control_thread.join();
-        return true;
-    }
-}
-
-int main(int argc, char* argv[]) {
-    using namespace TftpServer;
-
-    if (argc != expected_argc) {
-        std::cerr << "Invalid argc.\nusage: ./tftpd <port no.>\n";
-        return 1;
-    }
+        std::optional<Driver::FileWriter> file_writer;
 
-    const auto checked_port_arg = std::atoi(argv[1]);
+        /// NOTE: the writer outlives the workers, so uploads their sessions queued still get written and synced on shutdown.
+        if (config->write_behind_bytes > 0UL) {
+            file_writer.emplace(config->write_behind_bytes);
+        }
 
-    if (checked_port_arg <= Driver::min_free_port) {
-        std::cerr << "Invalid port number / transfer ID.\n";
-        return 1;
-    }
+        Driver::WorkerGroup app {config.value(), Driver::SessionResources {
+            .file_cache = &file_cache,
+            .packet_cache = packet_cache.has_value() ? &packet_cache.value() : nullptr,
+            .io_ring = nullptr,
+            .packet_pool = nullptr,
+            .file_writer = file_writer.has_value() ? &file_writer.value() : nullptr,
+            .metrics = nullptr,
+            .scheduler = nullptr,
+            .multicast = nullptr,
+            .timers = nullptr,
+            .reactor = nullptr,
+            .worker_id = 0U
+        }, metrics};
+
+        running_workers = &app;
+        installStopHandlers();
+
+        std::cout << "Send SIGINT (Ctrl+C) or SIGTERM to stop.\n";
+
+        if (not app.runService()) {
+            std::cerr << "Socket setup failed!\n";
+            return 1;
+        }
 
-    Driver::MyServer app {Driver::makeUDPSocket(argv[1])};
+        printCacheStats(file_cache);
 
-    if (not app.runService()) {
-        std::cerr << "Socket setup failed!\n";
+        if (packet_cache.has_value()) {
+            printPacketCacheStats(packet_cache.value());
+        }
+    } catch (const std::exception& setup_error) {
+        std::cerr << "Server setup failed: " << setup_error.what() << '\n';
         return 1;
     }
-}
\ No newline at end of file
+}
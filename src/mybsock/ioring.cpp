@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "mybsock/ioring.hpp"
+
+namespace TftpServer::MyBSock {
+    static constexpr auto dud_fd = -1;
+
+    [[nodiscard]] static int ringSetup(unsigned int entries, io_uring_params* params) noexcept {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    [[nodiscard]] static int ringEnter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags) noexcept {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0UL));
+    }
+
+    [[nodiscard]] static int ringRegister(int fd, unsigned int opcode, const void* arg, unsigned int arg_n) noexcept {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, arg_n));
+    }
+
+    [[nodiscard]] static unsigned int* ringField(void* ring_ptr, std::uint32_t offset) noexcept {
+        return reinterpret_cast<unsigned int*>(static_cast<unsigned char*>(ring_ptr) + offset);
+    }
+
+    IoRing::IoRing(unsigned int entries, unsigned int buffer_slots)
+    : m_free_buffers {}, m_sqes {nullptr}, m_cqes {nullptr}, m_sq_head {nullptr}, m_sq_tail {nullptr}, m_sq_array {nullptr}, m_cq_head {nullptr}, m_cq_tail {nullptr}, m_sq_ring_ptr {MAP_FAILED}, m_cq_ring_ptr {MAP_FAILED}, m_sq_ring_size {0}, m_cq_ring_size {0}, m_sqes_size {0}, m_sq_mask {0}, m_cq_mask {0}, m_sq_entries {0}, m_queued {0}, m_fd {dud_fd} {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+
+        m_fd = ringSetup(entries, &params);
+
+        if (m_fd < 0) {
+            m_fd = dud_fd;
+            throw std::runtime_error {"io_uring setup failed!"};
+        }
+
+        m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0U) {
+            m_sq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+            m_cq_ring_size = m_sq_ring_size;
+        }
+
+        m_sq_ring_ptr = mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+
+        if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0U) {
+            m_cq_ring_ptr = m_sq_ring_ptr;
+        } else if (m_sq_ring_ptr != MAP_FAILED) {
+            m_cq_ring_ptr = mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+        }
+
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        const auto sqes_ptr = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+
+        if (m_sq_ring_ptr == MAP_FAILED or m_cq_ring_ptr == MAP_FAILED or sqes_ptr == MAP_FAILED) {
+            if (sqes_ptr != MAP_FAILED) {
+                munmap(sqes_ptr, m_sqes_size);
+            }
+
+            closeRing();
+            throw std::runtime_error {"io_uring mapping failed!"};
+        }
+
+        m_sqes = static_cast<io_uring_sqe*>(sqes_ptr);
+        m_sq_head = ringField(m_sq_ring_ptr, params.sq_off.head);
+        m_sq_tail = ringField(m_sq_ring_ptr, params.sq_off.tail);
+        m_sq_array = ringField(m_sq_ring_ptr, params.sq_off.array);
+        m_sq_mask = *ringField(m_sq_ring_ptr, params.sq_off.ring_mask);
+        m_sq_entries = params.sq_entries;
+        m_cq_head = ringField(m_cq_ring_ptr, params.cq_off.head);
+        m_cq_tail = ringField(m_cq_ring_ptr, params.cq_off.tail);
+        m_cq_mask = *ringField(m_cq_ring_ptr, params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(static_cast<unsigned char*>(m_cq_ring_ptr) + params.cq_off.cqes);
+
+        /// NOTE: a sparse table reserves the slots up front, so buffers come and go later by single-slot updates. Without it, every read stays a plain read.
+        io_uring_rsrc_register buffer_table;
+        std::memset(&buffer_table, 0, sizeof(buffer_table));
+        buffer_table.nr = buffer_slots;
+        buffer_table.flags = IORING_RSRC_REGISTER_SPARSE;
+
+        if (buffer_slots > 0U and ringRegister(m_fd, IORING_REGISTER_BUFFERS2, &buffer_table, sizeof(buffer_table)) == 0) {
+            for (auto slot = buffer_slots; slot > 0U; slot--) {
+                m_free_buffers.push_back(slot - 1U);
+            }
+        }
+    }
+
+    IoRing::~IoRing() {
+        closeRing();
+    }
+
+    void IoRing::closeRing() noexcept {
+        if (m_sqes != nullptr) {
+            munmap(m_sqes, m_sqes_size);
+            m_sqes = nullptr;
+        }
+
+        if (m_cq_ring_ptr != MAP_FAILED and m_cq_ring_ptr != m_sq_ring_ptr) {
+            munmap(m_cq_ring_ptr, m_cq_ring_size);
+        }
+
+        if (m_sq_ring_ptr != MAP_FAILED) {
+            munmap(m_sq_ring_ptr, m_sq_ring_size);
+        }
+
+        m_cq_ring_ptr = MAP_FAILED;
+        m_sq_ring_ptr = MAP_FAILED;
+
+        if (m_fd != dud_fd) {
+            close(m_fd);
+            m_fd = dud_fd;
+        }
+    }
+
+    unsigned int IoRing::getFreeEntries() const noexcept {
+        const auto tail = *m_sq_tail + m_queued;
+        const auto head = std::atomic_ref<unsigned int> {*m_sq_head}.load(std::memory_order_acquire);
+
+        return m_sq_entries - (tail - head);
+    }
+
+    io_uring_sqe* IoRing::nextEntry() noexcept {
+        if (getFreeEntries() == 0U) {
+            return nullptr;
+        }
+
+        const auto index = (*m_sq_tail + m_queued) & m_sq_mask;
+        auto* entry = &m_sqes[index];
+
+        std::memset(entry, 0, sizeof(io_uring_sqe));
+        m_sq_array[index] = index;
+        m_queued++;
+
+        return entry;
+    }
+
+    void IoRing::fillRead(io_uring_sqe* entry, int fd, void* target, unsigned int length, std::uint64_t offset, std::optional<unsigned int> buffer_index, std::uint64_t tag) noexcept {
+        entry->opcode = buffer_index.has_value() ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        entry->fd = fd;
+        entry->addr = reinterpret_cast<std::uint64_t>(target);
+        entry->len = length;
+        entry->off = offset;
+        entry->buf_index = static_cast<std::uint16_t>(buffer_index.value_or(0U));
+        entry->user_data = tag;
+    }
+
+    void IoRing::fillSend(io_uring_sqe* entry, int fd, const msghdr* message, std::uint64_t tag) noexcept {
+        entry->opcode = IORING_OP_SENDMSG;
+        entry->fd = fd;
+        entry->addr = reinterpret_cast<std::uint64_t>(message);
+        entry->len = 1U;
+        entry->user_data = tag;
+    }
+
+    std::optional<unsigned int> IoRing::registerBuffer(void* ptr, std::size_t length) noexcept {
+        if (m_free_buffers.empty()) {
+            return {};
+        }
+
+        const auto buffer_index = m_free_buffers.back();
+        iovec buffer_vec {ptr, length};
+        io_uring_rsrc_update2 update;
+        std::memset(&update, 0, sizeof(update));
+        update.offset = buffer_index;
+        update.data = reinterpret_cast<std::uint64_t>(&buffer_vec);
+        update.nr = 1U;
+
+        if (ringRegister(m_fd, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update)) != 1) {
+            return {};
+        }
+
+        m_free_buffers.pop_back();
+
+        return buffer_index;
+    }
+
+    void IoRing::unregisterBuffer(unsigned int buffer_index) noexcept {
+        iovec empty_vec {nullptr, 0UL};
+        io_uring_rsrc_update2 update;
+        std::memset(&update, 0, sizeof(update));
+        update.offset = buffer_index;
+        update.data = reinterpret_cast<std::uint64_t>(&empty_vec);
+        update.nr = 1U;
+
+        if (ringRegister(m_fd, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update)) == 1) {
+            m_free_buffers.push_back(buffer_index);
+        }
+    }
+
+    bool IoRing::queueSend(int fd, const msghdr* message, std::uint64_t tag) noexcept {
+        auto* entry = nextEntry();
+
+        if (entry == nullptr) {
+            return false;
+        }
+
+        fillSend(entry, fd, message, tag);
+
+        return true;
+    }
+
+    bool IoRing::queueReadSend(int file_fd, void* target, unsigned int length, std::uint64_t offset, std::optional<unsigned int> buffer_index, std::uint64_t read_tag, int socket_fd, const msghdr* message, std::uint64_t send_tag) noexcept {
+        /// NOTE: a link only covers the very next entry, so a read queued without its send would wrongly chain to whatever comes after it.
+        if (getFreeEntries() < 2U) {
+            return false;
+        }
+
+        auto* read_entry = nextEntry();
+
+        fillRead(read_entry, file_fd, target, length, offset, buffer_index, read_tag);
+        read_entry->flags = IOSQE_IO_LINK;
+        fillSend(nextEntry(), socket_fd, message, send_tag);
+
+        return true;
+    }
+
+    std::size_t IoRing::submitAndWait() noexcept {
+        const auto submit_n = m_queued;
+
+        if (submit_n == 0U) {
+            return 0UL;
+        }
+
+        std::atomic_ref<unsigned int> {*m_sq_tail}.store(*m_sq_tail + submit_n, std::memory_order_release);
+        m_queued = 0;
+
+        auto pending_n = submit_n;
+        auto enter_rc = 0;
+
+        /// NOTE: the first enter submits and waits, while any later one only waits for what an interrupted wait left over.
+        do {
+            enter_rc = ringEnter(m_fd, pending_n, submit_n, IORING_ENTER_GETEVENTS);
+
+            if (enter_rc > 0) {
+                pending_n -= std::min(pending_n, static_cast<unsigned int>(enter_rc));
+            }
+
+            const auto ready_n = std::atomic_ref<unsigned int> {*m_cq_tail}.load(std::memory_order_acquire) - *m_cq_head;
+
+            if (pending_n == 0U and ready_n >= submit_n) {
+                break;
+            }
+        } while (enter_rc >= 0 or errno == EINTR or errno == EAGAIN or errno == EBUSY);
+
+        return submit_n - pending_n;
+    }
+
+    bool IoRing::popCompletion(IoCompletion& completion) noexcept {
+        const auto head = *m_cq_head;
+
+        if (head == std::atomic_ref<unsigned int> {*m_cq_tail}.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        const auto& entry = m_cqes[head & m_cq_mask];
+        completion = { entry.user_data, entry.res };
+
+        std::atomic_ref<unsigned int> {*m_cq_head}.store(head + 1U, std::memory_order_release);
+
+        return true;
+    }
+}
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <stdexcept>
 #include <unistd.h>
 #include <netdb.h>
@@ -10,10 +13,9 @@ namespace TftpServer::MyBSock {
     static constexpr const char* default_port_cstr = "8080";
     static constexpr auto bsock_ok = 0;
     static constexpr auto socket_fd_dud = -1;
-    static constexpr auto timeout_secs = 10L;
 
-    SocketGenerator::SocketGenerator(const char* port_cstr)
-    : m_head {nullptr}, m_cursor {nullptr} {
+    SocketGenerator::SocketGenerator(const char* port_cstr, bool reuse_port)
+    : m_head {nullptr}, m_cursor {nullptr}, m_reuse_port {reuse_port} {
         const auto* checked_port_cstr = (port_cstr != nullptr) ? port_cstr : default_port_cstr;
  
         addrinfo udp_config;
@@ -46,32 +48,77 @@ namespace TftpServer::MyBSock {
             return {};
         }
 
-        const auto socket_fd = socket(m_cursor->ai_family, m_cursor->ai_socktype, m_cursor->ai_protocol);
+        /// NOTE: the cursor moves past each address as it gets tried, so a failing one ends the caller's loop instead of getting retried forever.
+        const auto* candidate = m_cursor;
+        m_cursor = m_cursor->ai_next;
+
+        /// NOTE: sockets are driven by the reactor's readiness events, so a read must never park the whole loop on one peer.
+        const auto socket_fd = socket(candidate->ai_family, candidate->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, candidate->ai_protocol);
 
-        
         if (socket_fd == socket_fd_dud) {
             return {};
         }
 
-        timeval recv_timeout = {
-            .tv_sec = timeout_secs,
-            .tv_usec = 0
-        };
+        const int reuse_flag = 1;
 
-        const socklen_t timeval_size = sizeof(timeval);
-
-        if (setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &recv_timeout, timeval_size) != bsock_ok) {
+        if (m_reuse_port and setsockopt(socket_fd, SOL_SOCKET, SO_REUSEPORT, &reuse_flag, sizeof(reuse_flag)) != bsock_ok) {
             close(socket_fd);
             return {};
         }
 
-        if (bind(socket_fd, m_cursor->ai_addr, m_cursor->ai_addrlen) == socket_fd_dud) {
+        if (bind(socket_fd, candidate->ai_addr, candidate->ai_addrlen) == socket_fd_dud) {
             close(socket_fd);
             return {};
         }
 
-        m_cursor = m_cursor->ai_next;
-
         return {socket_fd};
     }
+
+    std::optional<std::size_t> queryPathMtu(const sockaddr_in& peer) {
+        const auto probe_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+        if (probe_fd == socket_fd_dud) {
+            return {};
+        }
+
+        /// NOTE: a connected UDP socket caches its route, so its `IP_MTU` reflects the outgoing interface, e.g. 9000 on jumbo-frame links.
+        int mtu = 0;
+        socklen_t mtu_size = sizeof(mtu);
+        const auto connect_ok = connect(probe_fd, reinterpret_cast<const sockaddr*>(&peer), sizeof(peer)) == bsock_ok;
+        const auto query_ok = connect_ok and getsockopt(probe_fd, IPPROTO_IP, IP_MTU, &mtu, &mtu_size) == bsock_ok;
+
+        close(probe_fd);
+
+        if (not query_ok or mtu <= 0) {
+            return {};
+        }
+
+        return {static_cast<std::size_t>(mtu)};
+    }
+
+    bool enableMulticastSend(int socket_fd, in_addr_t interface_ip) {
+        const in_addr interface_addr {interface_ip};
+        const unsigned char loop_flag = 1;
+
+        return setsockopt(socket_fd, IPPROTO_IP, IP_MULTICAST_IF, &interface_addr, sizeof(interface_addr)) == bsock_ok
+            and setsockopt(socket_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop_flag, sizeof(loop_flag)) == bsock_ok;
+    }
+
+    bool reserveSendBuffer(int socket_fd, std::size_t bytes) {
+        int current_size = 0;
+        socklen_t option_size = sizeof(current_size);
+
+        if (getsockopt(socket_fd, SOL_SOCKET, SO_SNDBUF, &current_size, &option_size) != bsock_ok) {
+            return false;
+        }
+
+        /// NOTE: the kernel doubles the requested size for its own bookkeeping and reports the doubled value, so the request is halved to compare like with like.
+        if (static_cast<std::size_t>(current_size) / 2UL >= bytes) {
+            return true;
+        }
+
+        const auto wanted_size = static_cast<int>(std::min<std::size_t>(bytes, std::numeric_limits<int>::max() / 2));
+
+        return setsockopt(socket_fd, SOL_SOCKET, SO_SNDBUF, &wanted_size, sizeof(wanted_size)) == bsock_ok;
+    }
 }
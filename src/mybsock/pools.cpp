@@ -0,0 +1,103 @@
+#include <bit>
+#include <sys/mman.h>
+#include "mybsock/pools.hpp"
+
+namespace TftpServer::MyBSock {
+    [[nodiscard]] static std::size_t toSizeClass(std::size_t length) noexcept {
+        const auto run_size = std::bit_ceil(std::max(length, PacketPool::min_run_size));
+
+        return static_cast<std::size_t>(std::countr_zero(run_size) - std::countr_zero(PacketPool::min_run_size));
+    }
+
+    [[nodiscard]] static std::size_t toRunSize(std::size_t size_class) noexcept {
+        return PacketPool::min_run_size << size_class;
+    }
+
+    PacketPool::PacketPool(std::size_t limit, bool huge_pages) noexcept
+    : m_free_runs {}, m_class_runs {}, m_regions {}, m_stats {0, 0, 0, 0}, m_limit {limit}, m_huge_pages {huge_pages} {}
+
+    PacketPool::~PacketPool() {
+        for (const auto& [region_ptr, region_size] : m_regions) {
+            munmap(region_ptr, region_size);
+        }
+    }
+
+    bool PacketPool::growClass(std::size_t size_class) noexcept {
+        const auto run_size = toRunSize(size_class);
+        /// NOTE: small runs get carved from whole regions. Under a tight limit, regions shrink so that one size class cannot claim the whole pool.
+        const auto room_bytes = (m_limit > m_stats.reserved_bytes) ? m_limit - m_stats.reserved_bytes : 0UL;
+        const auto wanted_size = std::min({region_size, room_bytes, m_limit / class_count});
+        const auto mapped_size = std::max(run_size, wanted_size / run_size * run_size);
+
+        if (m_stats.reserved_bytes + mapped_size > m_limit) {
+            return false;
+        }
+
+        void* region_ptr = MAP_FAILED;
+
+        if (m_huge_pages) {
+            region_ptr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            m_stats.huge_regions += (region_ptr != MAP_FAILED) ? 1UL : 0UL;
+        }
+
+        if (region_ptr == MAP_FAILED) {
+            region_ptr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if (region_ptr == MAP_FAILED) {
+                return false;
+            }
+
+            if (m_huge_pages) {
+                madvise(region_ptr, mapped_size, MADV_HUGEPAGE);
+            }
+        }
+
+        try {
+            m_regions.emplace_back(region_ptr, mapped_size);
+            m_free_runs[size_class].reserve(m_class_runs[size_class] + mapped_size / run_size);
+        } catch (...) {
+            munmap(region_ptr, mapped_size);
+            return false;
+        }
+
+        auto* region_octets = static_cast<unsigned char*>(region_ptr);
+
+        for (auto run_offset = mapped_size; run_offset >= run_size; run_offset -= run_size) {
+            m_free_runs[size_class].push_back(region_octets + run_offset - run_size);
+        }
+
+        m_class_runs[size_class] += mapped_size / run_size;
+        m_stats.reserved_bytes += mapped_size;
+
+        return true;
+    }
+
+    std::optional<PacketRun> PacketPool::acquire(std::size_t length) noexcept {
+        const auto size_class = toSizeClass(length);
+
+        if (size_class >= class_count or (m_free_runs[size_class].empty() and not growClass(size_class))) {
+            m_stats.failed_acquires++;
+            return {};
+        }
+
+        auto* run_ptr = m_free_runs[size_class].back();
+        m_free_runs[size_class].pop_back();
+        m_stats.used_bytes += toRunSize(size_class);
+
+        return PacketRun {run_ptr, toRunSize(size_class), size_class};
+    }
+
+    void PacketPool::release(const PacketRun& run) noexcept {
+        /// NOTE: capacity for every run of the class was reserved while growing it, so this never allocates.
+        m_free_runs[run.size_class].push_back(run.ptr);
+        m_stats.used_bytes -= run.size;
+    }
+
+    const PacketPoolStats& PacketPool::getStats() const noexcept {
+        return m_stats;
+    }
+
+    std::size_t PacketPool::getRunSize(std::size_t length) noexcept {
+        return toRunSize(toSizeClass(length));
+    }
+}
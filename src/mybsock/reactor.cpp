@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include "mybsock/reactor.hpp"
+
+namespace TftpServer::MyBSock {
+    static constexpr auto dud_fd = -1;
+    static constexpr auto max_epoll_batch = 64UL;
+
+    Reactor::Reactor()
+    : m_epoll_fd {epoll_create1(EPOLL_CLOEXEC)}, m_stop_fd {eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)}, m_timer_fd {timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)} {
+        if (not isUsable()) {
+            closeDescriptors();
+            throw std::runtime_error {"Reactor setup failed!"};
+        }
+
+        /// NOTE: the reactor's own descriptors are told apart from watched ones by their context pointing back at the fd members.
+        epoll_event stop_event {.events = EPOLLIN, .data = {.ptr = &m_stop_fd}};
+        epoll_event timer_event {.events = EPOLLIN, .data = {.ptr = &m_timer_fd}};
+
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_stop_fd, &stop_event) != 0 or epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_timer_fd, &timer_event) != 0) {
+            closeDescriptors();
+            throw std::runtime_error {"Reactor setup failed!"};
+        }
+    }
+
+    Reactor::~Reactor() {
+        closeDescriptors();
+    }
+
+    void Reactor::closeDescriptors() noexcept {
+        for (auto* fd_ptr : {&m_timer_fd, &m_stop_fd, &m_epoll_fd}) {
+            if (*fd_ptr != dud_fd) {
+                close(*fd_ptr);
+                *fd_ptr = dud_fd;
+            }
+        }
+    }
+
+    bool Reactor::isUsable() const noexcept {
+        return m_epoll_fd != dud_fd and m_stop_fd != dud_fd and m_timer_fd != dud_fd;
+    }
+
+    bool Reactor::watch(int fd, void* context) noexcept {
+        epoll_event event {.events = EPOLLIN, .data = {.ptr = context}};
+
+        return epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+    }
+
+    void Reactor::unwatch(int fd) noexcept {
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    bool Reactor::watchWritable(int fd, void* context, bool writable) noexcept {
+        epoll_event event {.events = EPOLLIN | (writable ? static_cast<std::uint32_t>(EPOLLOUT) : 0U), .data = {.ptr = context}};
+
+        return epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &event) == 0;
+    }
+
+    bool Reactor::armTicks(std::chrono::milliseconds period) noexcept {
+        const auto period_secs = period.count() / 1000L;
+        const auto period_nsecs = (period.count() % 1000L) * 1000000L;
+
+        itimerspec timer_spec {
+            .it_interval = {.tv_sec = period_secs, .tv_nsec = period_nsecs},
+            .it_value = {.tv_sec = period_secs, .tv_nsec = period_nsecs}
+        };
+
+        return timerfd_settime(m_timer_fd, 0, &timer_spec, nullptr) == 0;
+    }
+
+    void Reactor::requestStop() const noexcept {
+        const std::uint64_t signal_count = 1;
+
+        [[maybe_unused]] const auto write_rc = write(m_stop_fd, &signal_count, sizeof(signal_count));
+    }
+
+    std::size_t Reactor::waitEvents(std::span<ReactorEvent> events, int timeout_ms) {
+        std::array<epoll_event, max_epoll_batch> raw_events;
+        const auto wanted_n = static_cast<int>(std::min(events.size(), raw_events.size()));
+
+        int ready_n = 0;
+
+        do {
+            ready_n = epoll_wait(m_epoll_fd, raw_events.data(), wanted_n, timeout_ms);
+        } while (ready_n < 0 and errno == EINTR);
+
+        if (ready_n <= 0) {
+            return 0UL;
+        }
+
+        for (auto event_index = 0; event_index < ready_n; event_index++) {
+            const auto& raw_event = raw_events[event_index];
+            auto& event = events[event_index];
+
+            if (raw_event.data.ptr == &m_stop_fd) {
+                event = {nullptr, 0, EventKind::stop};
+            } else if (raw_event.data.ptr == &m_timer_fd) {
+                std::uint64_t expirations = 0;
+                [[maybe_unused]] const auto read_rc = read(m_timer_fd, &expirations, sizeof(expirations));
+
+                event = {nullptr, expirations, EventKind::tick};
+            } else if ((raw_event.events & EPOLLIN) == 0U and (raw_event.events & EPOLLOUT) != 0U) {
+                event = {raw_event.data.ptr, 0, EventKind::writable};
+            } else {
+                event = {raw_event.data.ptr, 0, EventKind::readable};
+            }
+        }
+
+        return static_cast<std::size_t>(ready_n);
+    }
+}
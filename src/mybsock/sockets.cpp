@@ -8,6 +8,10 @@ namespace TftpServer::MyBSock {
         return not m_closed and m_ready;
     }
 
+    int UDPServerSocket::getFd() const noexcept {
+        return m_fd;
+    }
+
     UDPServerSocket::UDPServerSocket() noexcept
     : m_fd {dud_socket_fd}, m_ready {false}, m_closed {true} {}
 
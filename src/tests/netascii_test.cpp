@@ -0,0 +1,213 @@
+/**
+ * @file netascii_test.cpp
+ * @brief Checks the scalar, SSE2, and AVX2 netascii kernels against a plain RFC 764 reference on random text, with a block boundary at every offset, in both directions. Exits non-zero on the first failed check.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <print>
+#include <random>
+#include <string_view>
+#include <vector>
+#include "mytftp/netascii.hpp"
+
+namespace TftpServer::Tests {
+    using namespace TftpServer::MyTftp;
+    using Octets = std::vector<tftp_u8>;
+
+    /// NOTE: texts run past two AVX2 vectors, so runs break inside, across, and right at vector edges.
+    static constexpr auto random_text_count = 300UL;
+    static constexpr auto random_text_max_size = 100UL;
+    static constexpr auto random_seed = 764U;
+    /// NOTE: large enough that the rest of a text always fits one block.
+    static constexpr auto whole_block_size = 4UL * random_text_max_size;
+
+    [[nodiscard]] static bool check(bool passed, std::string_view kernel, std::string_view what) {
+        if (not passed) {
+            std::print(stderr, "netascii-test: {} kernel, {} failed\n", kernel, what);
+        }
+
+        return passed;
+    }
+
+    [[nodiscard]] static Octets toOctets(std::string_view text) {
+        return {text.begin(), text.end()};
+    }
+
+    /// NOTE: the translation RFC 764 asks for, one octet at a time with no carries.
+    [[nodiscard]] static Octets encodeReference(const Octets& text) {
+        Octets wire;
+
+        for (const auto octet : text) {
+            if (octet == ascii_lf) {
+                wire.insert(wire.end(), {ascii_cr, ascii_lf});
+            } else if (octet == ascii_cr) {
+                wire.insert(wire.end(), {ascii_cr, ascii_nul});
+            } else {
+                wire.push_back(octet);
+            }
+        }
+
+        return wire;
+    }
+
+    [[nodiscard]] static Octets decodeReference(const Octets& wire) {
+        Octets text;
+
+        for (auto wire_pos = 0UL; wire_pos < wire.size(); wire_pos++) {
+            const auto octet = wire[wire_pos];
+
+            if (octet != ascii_cr or wire_pos + 1UL == wire.size()) {
+                text.push_back(octet);
+            } else if (wire[wire_pos + 1UL] == ascii_lf) {
+                text.push_back(ascii_lf);
+                wire_pos++;
+            } else if (wire[wire_pos + 1UL] == ascii_nul) {
+                text.push_back(ascii_cr);
+                wire_pos++;
+            } else {
+                text.push_back(ascii_cr);
+            }
+        }
+
+        return text;
+    }
+
+    /// NOTE: as a session sends it, the first DATA block holding `first_block_size` octets and later ones up to `whole_block_size`, until the text and any carried octet are out.
+    template <typename Scan>
+    [[nodiscard]] static Octets encodeInBlocks(const Octets& text, std::size_t source_split, std::size_t first_block_size) {
+        Octets wire;
+        Octets block(whole_block_size);
+        NetasciiCarry carry {ascii_nul, false};
+        auto in_pos = 0UL;
+        auto block_size = first_block_size;
+
+        while (in_pos < text.size() or carry.pending) {
+            const auto source_end = (in_pos < source_split) ? source_split : text.size();
+            const auto [consumed_n, produced_n] = encodeNetasciiWith<Scan>({text.data() + in_pos, source_end - in_pos}, block.data(), block_size, carry);
+
+            in_pos += consumed_n;
+            wire.insert(wire.end(), block.begin(), block.begin() + static_cast<long>(produced_n));
+            block_size = whole_block_size;
+        }
+
+        return wire;
+    }
+
+    /// NOTE: as a session stores an upload arriving in two DATA blocks split at `split`, then flushes a CR left over at the end.
+    template <typename Scan>
+    [[nodiscard]] static Octets decodeInBlocks(const Octets& wire, std::size_t split) {
+        Octets text(wire.size() + 2UL);
+        NetasciiCarry carry {ascii_nul, false};
+        auto out_pos = decodeNetasciiWith<Scan>({wire.data(), split}, text.data(), carry);
+
+        out_pos += decodeNetasciiWith<Scan>({wire.data() + split, wire.size() - split}, text.data() + out_pos, carry);
+        out_pos += finishNetasciiDecode(text.data() + out_pos, carry);
+        text.resize(out_pos);
+
+        return text;
+    }
+
+    /// NOTE: line breaks, CRs, and NULs show up often enough that most vectors hold one, and pairs land on every boundary.
+    [[nodiscard]] static std::vector<Octets> makeRandomTexts() {
+        static constexpr std::string_view alphabet {"\r\n\0abcdefgh \t", 13};
+
+        std::mt19937 engine {random_seed};
+        std::uniform_int_distribution<std::size_t> size_dist {0UL, random_text_max_size};
+        std::uniform_int_distribution<std::size_t> octet_dist {0UL, alphabet.size() * 3UL - 1UL};
+        std::vector<Octets> texts;
+
+        for (auto text_index = 0UL; text_index < random_text_count; text_index++) {
+            Octets text(size_dist(engine));
+
+            /// NOTE: every third text is plain, so the kernels' long copy runs get covered too.
+            for (auto& octet : text) {
+                const auto pick = octet_dist(engine);
+
+                octet = static_cast<tftp_u8>((text_index % 3UL == 0UL or pick >= alphabet.size()) ? 'a' + pick % 26UL : alphabet[pick]);
+            }
+
+            texts.push_back(std::move(text));
+        }
+
+        return texts;
+    }
+
+    template <typename Scan>
+    [[nodiscard]] static bool checkCarryCases(std::string_view kernel) {
+        const auto cr_at_block_end = encodeInBlocks<Scan>(toOctets("ab\rcd"), 5UL, 3UL) == toOctets({"ab\r\0cd", 6});
+        const auto lf_at_block_end = encodeInBlocks<Scan>(toOctets("ab\ncd"), 5UL, 3UL) == toOctets("ab\r\ncd");
+        const auto cr_at_source_end = encodeInBlocks<Scan>(toOctets("ab\rcd"), 3UL, whole_block_size) == toOctets({"ab\r\0cd", 6});
+        const auto split_cr_lf = decodeInBlocks<Scan>(toOctets("ab\r\ncd"), 3UL) == toOctets("ab\ncd");
+        const auto split_cr_nul = decodeInBlocks<Scan>(toOctets({"ab\r\0cd", 6}), 3UL) == toOctets("ab\rcd");
+        const auto split_cr_cr_lf = decodeInBlocks<Scan>(toOctets("ab\r\r\n"), 3UL) == toOctets("ab\r\n");
+        const auto lone_trailing_cr = decodeInBlocks<Scan>(toOctets("ab\r"), 3UL) == toOctets("ab\r");
+
+        return check(cr_at_block_end, kernel, "CR at the end of a DATA block")
+            and check(lf_at_block_end, kernel, "LF at the end of a DATA block")
+            and check(cr_at_source_end, kernel, "CR at the end of a file read")
+            and check(split_cr_lf, kernel, "CR LF split across blocks")
+            and check(split_cr_nul, kernel, "CR NUL split across blocks")
+            and check(split_cr_cr_lf, kernel, "CR CR LF split across blocks")
+            and check(lone_trailing_cr, kernel, "lone CR ending an upload");
+    }
+
+    template <typename Scan>
+    [[nodiscard]] static bool checkKernel(std::string_view kernel, const std::vector<Octets>& texts) {
+        if (not checkCarryCases<Scan>(kernel)) {
+            return false;
+        }
+
+        for (const auto& text : texts) {
+            const auto wire = encodeReference(text);
+
+            /// NOTE: every offset of the output gets a DATA block boundary, and every offset of the input a file read boundary.
+            for (auto split = 0UL; split <= wire.size(); split++) {
+                if (not check(encodeInBlocks<Scan>(text, text.size(), std::max(split, 1UL)) == wire, kernel, "encoding split at a block boundary")) {
+                    return false;
+                }
+            }
+
+            for (auto split = 0UL; split <= text.size(); split++) {
+                if (not check(encodeInBlocks<Scan>(text, split, whole_block_size) == wire, kernel, "encoding split at a file read")) {
+                    return false;
+                }
+            }
+
+            /// NOTE: the raw text doubles as netascii input a sloppy peer might send, with CRs before arbitrary octets and at the very end.
+            for (const auto* input : {&wire, &text}) {
+                const auto expected = decodeReference(*input);
+
+                for (auto split = 0UL; split <= input->size(); split++) {
+                    if (not check(decodeInBlocks<Scan>(*input, split) == expected, kernel, "decoding split at a block boundary")) {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    [[nodiscard]] static bool runChecks() {
+        const auto texts = makeRandomTexts();
+        auto all_passed = checkKernel<ScalarScan>("scalar", texts);
+
+#if defined(__SSE2__)
+        all_passed = checkKernel<Sse2Scan>("SSE2", texts) and all_passed;
+#endif
+#if defined(__x86_64__)
+        if (hasAvx2()) {
+            all_passed = checkKernel<Avx2Scan>("AVX2", texts) and all_passed;
+        } else {
+            std::print(stderr, "netascii-test: no AVX2 on this CPU, skipping its kernel\n");
+        }
+#endif
+
+        return all_passed;
+    }
+}
+
+int main() {
+    return TftpServer::Tests::runChecks() ? 0 : 1;
+}